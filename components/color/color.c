@@ -31,7 +31,7 @@
 #define HSV_SECTION_6 (0x20)
 #define HSV_SECTION_3 (0x40)
 
-rgb_t hsv2rgb_raw(hsv_t hsv)
+static inline rgb_t raw2rgb(hsv_t hsv)
 {
     // Convert hue, saturation and brightness ( HSV/HSB ) to RGB
     // "Dimming" is used on saturation and brightness to make
@@ -125,10 +125,20 @@ rgb_t hsv2rgb_raw(hsv_t hsv)
     return rgb;
 }
 
-rgb_t hsv2rgb_spectrum(hsv_t hsv)
+rgb_t hsv2rgb_raw(hsv_t hsv)
+{
+    return raw2rgb(hsv);
+}
+
+static inline rgb_t spectrum2rgb(hsv_t hsv)
 {
     hsv.hue = scale8(hsv.hue, HUE_MAX_RAW);
-    return hsv2rgb_raw(hsv);
+    return raw2rgb(hsv);
+}
+
+rgb_t hsv2rgb_spectrum(hsv_t hsv)
+{
+    return spectrum2rgb(hsv);
 }
 
 #define K255 255
@@ -136,7 +146,7 @@ rgb_t hsv2rgb_spectrum(hsv_t hsv)
 #define K170 170
 #define K85  85
 
-rgb_t hsv2rgb_rainbow(hsv_t hsv)
+static inline rgb_t rainbow2rgb(hsv_t hsv)
 {
     // Yellow has a higher inherent brightness than
     // any other color; 'pure' yellow is perceived to
@@ -349,6 +359,46 @@ rgb_t hsv2rgb_rainbow(hsv_t hsv)
     return rgb_from_values(r, g, b);
 }
 
+rgb_t hsv2rgb_rainbow(hsv_t hsv)
+{
+    return rainbow2rgb(hsv);
+}
+
+void hsv2rgb_rainbow_array(const hsv_t *src, rgb_t *dst, size_t num)
+{
+    for (size_t i = 0; i < num; i++)
+        dst[i] = rainbow2rgb(src[i]);
+}
+
+void hsv2rgb_spectrum_array(const hsv_t *src, rgb_t *dst, size_t num)
+{
+    for (size_t i = 0; i < num; i++)
+        dst[i] = spectrum2rgb(src[i]);
+}
+
+void hsv2rgb_raw_array(const hsv_t *src, rgb_t *dst, size_t num)
+{
+    for (size_t i = 0; i < num; i++)
+        dst[i] = raw2rgb(src[i]);
+}
+
+void hue_table_init(hue_table_t *table, hsv2rgb_cb_t convert, uint8_t sat, uint8_t val)
+{
+    if (!table)
+        return;
+    if (!convert)
+        convert = hsv2rgb_rainbow;
+
+    for (int hue = 0; hue < 256; hue++)
+        table->colors[hue] = convert(hsv_from_values(hue, sat, val));
+}
+
+void hue_table_convert(const hue_table_t *table, const uint8_t *hues, rgb_t *dst, size_t num)
+{
+    for (size_t i = 0; i < num; i++)
+        dst[i] = table->colors[hues[i]];
+}
+
 #define FIXFRAC8(N,D) (((N) * 256) / (D))
 
 // This function is only an approximation, and it is not
@@ -581,7 +631,7 @@ void hsv_fill_solid_hsv(hsv_t *target, hsv_t color, size_t num)
 
 void rgb_fill_solid_hsv(rgb_t *target, hsv_t color, size_t num)
 {
-    rgb_t rgb = hsv2rgb_rainbow(color);
+    rgb_t rgb = rainbow2rgb(color);
     for (size_t i = 0; i < num; ++i)
         target[i] = rgb;
 }
@@ -755,7 +805,7 @@ void rgb_fill_gradient_hsv(rgb_t *target, size_t startpos, hsv_t startcolor, siz
     accum88 val88 = startcolor.val << 8;
     for (size_t i = startpos; i <= endpos; ++i)
     {
-        target[i] = hsv2rgb_rainbow(hsv_from_values(hue88 >> 8, sat88 >> 8, val88 >> 8));
+        target[i] = rainbow2rgb(hsv_from_values(hue88 >> 8, sat88 >> 8, val88 >> 8));
         hue88 += huedelta87;
         sat88 += satdelta87;
         val88 += valdelta87;
@@ -947,6 +997,30 @@ rgb_t color_from_palette_rgb(const rgb_t *palette, uint8_t pal_size, uint8_t ind
     return rgb_from_values(red1, green1, blue1);
 }
 
+void rgb_palette_init_rgb(rgb_palette_t *pal, const rgb_t *palette, uint8_t pal_size, uint8_t brightness, bool blend)
+{
+    if (!pal || !palette || !pal_size)
+        return;
+
+    for (int i = 0; i < 256; i++)
+        pal->colors[i] = color_from_palette_rgb(palette, pal_size, i, brightness, blend);
+}
+
+void rgb_palette_init_hsv(rgb_palette_t *pal, const hsv_t *palette, uint8_t pal_size, uint8_t brightness, bool blend)
+{
+    if (!pal || !palette || !pal_size)
+        return;
+
+    for (int i = 0; i < 256; i++)
+        pal->colors[i] = rainbow2rgb(color_from_palette_hsv(palette, pal_size, i, brightness, blend));
+}
+
+void rgb_palette_map(const rgb_palette_t *pal, const uint8_t *indices, rgb_t *dst, size_t num)
+{
+    for (size_t i = 0; i < num; i++)
+        dst[i] = pal->colors[indices[i]];
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 hsv_t blend(hsv_t existing, hsv_t overlay, fract8 amount, color_gradient_direction_t direction)
@@ -993,21 +1067,100 @@ hsv_t blend(hsv_t existing, hsv_t overlay, fract8 amount, color_gradient_directi
     return existing;
 }
 
+// Row-major blur kernels.
+// R and B are packed into two 16-bit lanes of one 32-bit word and G is kept
+// in the other one, so scale8 takes two multiplications per pixel instead of
+// three. Results are bit-exact with rgb_scale() and rgb_add_rgb().
+
+#define BLUR_TILE_WIDTH 16
+
+typedef struct
+{
+    uint32_t rb;
+    uint32_t g;
+} rgb_packed_t;
+
+static inline rgb_packed_t pack_rgb(rgb_t c)
+{
+    rgb_packed_t res = { c.r | ((uint32_t)c.b << 16), c.g };
+    return res;
+}
+
+static inline rgb_t unpack_rgb(rgb_packed_t c)
+{
+    rgb_t res = { .r = c.rb, .g = c.g, .b = c.rb >> 16 };
+    return res;
+}
+
+static inline rgb_packed_t packed_scale8(rgb_packed_t c, uint8_t scale)
+{
+    uint32_t s = 1 + (uint32_t)scale;
+    rgb_packed_t res = { ((c.rb * s) >> 8) & 0x00ff00ff, (c.g * s) >> 8 };
+    return res;
+}
+
+static inline rgb_packed_t packed_qadd8(rgb_packed_t a, rgb_packed_t b)
+{
+    uint32_t rb = a.rb + b.rb;
+    uint32_t g = a.g + b.g;
+    // spread lane overflow bits to the whole lane
+    rgb_packed_t res = { (rb | (((rb >> 8) & 0x00010001) * 0xff)) & 0x00ff00ff, g > 0xff ? 0xff : g };
+    return res;
+}
+
+static void blur_rows_rm(rgb_t *leds, size_t width, size_t height, uint8_t keep, uint8_t seep)
+{
+    for (size_t row = 0; row < height; row++, leds += width)
+    {
+        // previous pixel stays in registers until its neighbour's part is added
+        rgb_packed_t c = pack_rgb(leds[0]);
+        rgb_packed_t carryover = packed_scale8(c, seep);
+        rgb_packed_t last = packed_scale8(c, keep);
+        for (size_t i = 1; i < width; i++)
+        {
+            c = pack_rgb(leds[i]);
+            rgb_packed_t part = packed_scale8(c, seep);
+            leds[i - 1] = unpack_rgb(packed_qadd8(last, part));
+            last = packed_qadd8(packed_scale8(c, keep), carryover);
+            carryover = part;
+        }
+        leds[width - 1] = unpack_rgb(last);
+    }
+}
+
 void blur1d(rgb_t *leds, size_t num_leds, fract8 blur_amount)
 {
-    uint8_t keep = 255 - blur_amount;
-    uint8_t seep = blur_amount >> 1;
-    rgb_t carryover = rgb_from_code(0);
-    for (size_t i = 0; i < num_leds; ++i)
+    if (num_leds)
+        blur_rows_rm(leds, num_leds, 1, 255 - blur_amount, blur_amount >> 1);
+}
+
+static void blur_columns_rm(rgb_t *leds, size_t width, size_t height, uint8_t keep, uint8_t seep)
+{
+    // walk rows of narrow column tiles instead of whole columns to stay in cache
+    rgb_packed_t carryover[BLUR_TILE_WIDTH];
+    for (size_t col = 0; col < width; col += BLUR_TILE_WIDTH)
     {
-        rgb_t cur = leds[i];
-        rgb_t part = cur;
-        part = rgb_scale(part, seep);
-        cur = rgb_add_rgb(rgb_scale(cur, keep), carryover);
-        if (i)
-            leds[i - 1] = rgb_add_rgb(leds[i - 1], part);
-        leds[i] = cur;
-        carryover = part;
+        size_t n = width - col < BLUR_TILE_WIDTH ? width - col : BLUR_TILE_WIDTH;
+        rgb_t *cur = leds + col;
+        for (size_t k = 0; k < n; k++)
+        {
+            rgb_packed_t c = pack_rgb(cur[k]);
+            carryover[k] = packed_scale8(c, seep);
+            cur[k] = unpack_rgb(packed_scale8(c, keep));
+        }
+        for (size_t row = 1; row < height; row++)
+        {
+            rgb_t *prev = cur;
+            cur += width;
+            for (size_t k = 0; k < n; k++)
+            {
+                rgb_packed_t c = pack_rgb(cur[k]);
+                rgb_packed_t part = packed_scale8(c, seep);
+                prev[k] = unpack_rgb(packed_qadd8(pack_rgb(prev[k]), part));
+                cur[k] = unpack_rgb(packed_qadd8(packed_scale8(c, keep), carryover[k]));
+                carryover[k] = part;
+            }
+        }
     }
 }
 
@@ -1016,6 +1169,13 @@ void blur_columns(rgb_t *leds, size_t width, size_t height, fract8 blur_amount,
     // blur columns
     uint8_t keep = 255 - blur_amount;
     uint8_t seep = blur_amount >> 1;
+    if (!width || !height)
+        return;
+    if (!xy)
+    {
+        blur_columns_rm(leds, width, height, keep, seep);
+        return;
+    }
     for (size_t col = 0; col < width; ++col)
     {
         rgb_t carryover = rgb_from_code(0);
@@ -1042,6 +1202,13 @@ void blur_rows(rgb_t *leds, size_t width, size_t height, fract8 blur_amount, xy_
     // blur rows same as columns, for irregular matrix
     uint8_t keep = 255 - blur_amount;
     uint8_t seep = blur_amount >> 1;
+    if (!width || !height)
+        return;
+    if (!xy)
+    {
+        blur_rows_rm(leds, width, height, keep, seep);
+        return;
+    }
     for (size_t row = 0; row < height; row++)
     {
         rgb_t carryover = rgb_from_code(0);
@@ -39,6 +39,7 @@
 
 #include "rgb.h"
 #include "hsv.h"
+#include "rgb_array.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -95,6 +96,80 @@ rgb_t hsv2rgb_spectrum(hsv_t hsv);
  */
 rgb_t hsv2rgb_raw(hsv_t hsv);
 
+/**
+ * @brief Convert array of HSV colors to RGB using balanced rainbow
+ *
+ * Same as hsv2rgb_rainbow() for each element, without call per color.
+ *
+ * @param src   Source HSV colors
+ * @param dst   Destination RGB colors
+ * @param num   Number of colors
+ */
+void hsv2rgb_rainbow_array(const hsv_t *src, rgb_t *dst, size_t num);
+
+/**
+ * @brief Convert array of HSV colors to RGB using mathematically straight spectrum
+ *
+ * Same as hsv2rgb_spectrum() for each element, without call per color.
+ *
+ * @param src   Source HSV colors
+ * @param dst   Destination RGB colors
+ * @param num   Number of colors
+ */
+void hsv2rgb_spectrum_array(const hsv_t *src, rgb_t *dst, size_t num);
+
+/**
+ * @brief Convert array of HSV colors to RGB using spectrum
+ *
+ * Same as hsv2rgb_raw() for each element, without call per color.
+ *
+ * @param src   Source HSV colors, hue 0-191
+ * @param dst   Destination RGB colors
+ * @param num   Number of colors
+ */
+void hsv2rgb_raw_array(const hsv_t *src, rgb_t *dst, size_t num);
+
+/**
+ * HSV to RGB conversion function, such as hsv2rgb_rainbow()
+ */
+typedef rgb_t (*hsv2rgb_cb_t)(hsv_t hsv);
+
+/**
+ * Precomputed RGB colors of all hues for fixed saturation and value
+ */
+typedef struct
+{
+    rgb_t colors[256];
+} hue_table_t;
+
+/**
+ * @brief Fill hue table
+ *
+ * @param table   Table to fill
+ * @param convert Conversion function, hsv2rgb_rainbow() if NULL
+ * @param sat     Saturation
+ * @param val     Value
+ */
+void hue_table_init(hue_table_t *table, hsv2rgb_cb_t convert, uint8_t sat, uint8_t val);
+
+/**
+ * @brief Get RGB color of hue from table
+ */
+static inline rgb_t hue_table_get(const hue_table_t *table, uint8_t hue)
+{
+    return table->colors[hue];
+}
+
+/**
+ * @brief Convert array of hues to RGB colors using table
+ *
+ * @param table   Hue table
+ * @param hues    Source hues
+ * @param dst     Destination RGB colors
+ * @param num     Number of colors
+ */
+void hue_table_convert(const hue_table_t *table, const uint8_t *hues, rgb_t *dst, size_t num);
+
 /**
  * @brief Recover approximate HSV values from RGB
  *
@@ -281,12 +356,73 @@ hsv_t color_from_palette_hsv(const hsv_t *palette, uint8_t pal_size, uint8_t ind
  */
 rgb_t color_from_palette_rgb(const rgb_t *palette, uint8_t pal_size, uint8_t index, uint8_t brightness, bool blend);
 
+/**
+ * Palette expanded to 256 RGB colors.
+ *
+ * Expanding a palette once turns every subsequent lookup into a single
+ * table read instead of a division, a blend and a brightness scale.
+ */
+typedef struct
+{
+    rgb_t colors[256];
+} rgb_palette_t;
+
+/**
+ * @brief Expand RGB palette to 256 colors
+ *
+ * Entries are exactly what color_from_palette_rgb() would return for
+ * every index.
+ *
+ * @param pal        Expanded palette to fill
+ * @param palette    Source palette entries
+ * @param pal_size   Number of source palette entries
+ * @param brightness Brightness, 255 is full
+ * @param blend      Blend adjacent entries
+ */
+void rgb_palette_init_rgb(rgb_palette_t *pal, const rgb_t *palette, uint8_t pal_size, uint8_t brightness, bool blend);
+
+/**
+ * @brief Expand HSV palette to 256 colors
+ *
+ * Entries are color_from_palette_hsv() results converted with
+ * hsv2rgb_rainbow().
+ *
+ * @param pal        Expanded palette to fill
+ * @param palette    Source palette entries
+ * @param pal_size   Number of source palette entries
+ * @param brightness Brightness, 255 is full
+ * @param blend      Blend adjacent entries
+ */
+void rgb_palette_init_hsv(rgb_palette_t *pal, const hsv_t *palette, uint8_t pal_size, uint8_t brightness, bool blend);
+
+/**
+ * @brief Get color with 'index' from expanded palette
+ */
+static inline rgb_t rgb_palette_get(const rgb_palette_t *pal, uint8_t index)
+{
+    return pal->colors[index];
+}
+
+/**
+ * @brief Convert array of palette indices to RGB colors
+ *
+ * @param pal     Expanded palette
+ * @param indices Source palette indices
+ * @param dst     Destination RGB colors
+ * @param num     Number of colors
+ */
+void rgb_palette_map(const rgb_palette_t *pal, const uint8_t *indices, rgb_t *dst, size_t num);
+
 ////////////////////////////////////////////////////////////////////////////////
 // Filter functions
 
 /**
  * Function which must be provided by the application for use in two-dimensional
  * filter functions.
+ *
+ * Pass NULL instead of the function if matrix is a plain row-major array
+ * (offset = y * width + x): specialised kernels without per-pixel calls
+ * will be used.
  */
 typedef size_t (*xy_to_offs_cb)(void *ctx, size_t x, size_t y);
 
@@ -342,6 +478,9 @@ void blur2d(rgb_t *leds, size_t width, size_t height, fract8 blur_amount, xy_to_
 /**
  * @brief Single gamma adjustment to a single scalar value.
  *
+ * Calls powf(), use rgb_lut_init() and rgb_lut_apply() or
+ * rgb_array_apply_lut() to gamma-correct whole frames.
+ *
  * Bear in mind that RGB leds have only eight bits per channel of color resolution,
  * and that very small, subtle shadings may not be visible.
  */
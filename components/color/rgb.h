@@ -66,6 +66,12 @@ static inline bool rgb_is_zero(rgb_t a)
     return !(a.r | a.g | a.b);
 }
 
+/// Check if two colors are equal
+static inline bool rgb_is_equal(rgb_t a, rgb_t b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
 /// Create rgb_t color from 24-bit color code 0x00RRGGBB
 static inline rgb_t rgb_from_code(uint32_t color_code)
 {
@@ -0,0 +1,165 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2021 Ruslan V. Uss <unclerus@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file rgb_array.c
+ *
+ * Bulk operations on arrays of RGB colors
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <string.h>
+#include "color.h"
+#include "rgb_array.h"
+
+// Even and odd bytes of a word are handled in two passes with 16-bit lanes,
+// 8-bit * 9-bit products fit a lane without carry into the next one.
+#define LANES 0x00ff00ffu
+
+static inline uint32_t load32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void store32(uint8_t *p, uint32_t v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+// scale8() of four bytes, s = 1 + scale
+static inline uint32_t scale8x4(uint32_t v, uint32_t s)
+{
+    return ((((v & LANES) * s) >> 8) & LANES) | ((((v >> 8) & LANES) * s) & ~LANES);
+}
+
+// qadd8() of four bytes
+static inline uint32_t qadd8x4(uint32_t a, uint32_t b)
+{
+    uint32_t sum = (a & 0x7f7f7f7fu) + (b & 0x7f7f7f7fu);
+    sum ^= (a ^ b) & 0x80808080u;
+    uint32_t overflow = ((a & b) | ((a | b) & ~sum)) & 0x80808080u;
+    return sum | ((overflow >> 7) * 0xff);
+}
+
+// blend8() of four bytes: (a * (256 - k) + b * (k + 1)) >> 8
+static inline uint32_t blend8x4(uint32_t a, uint32_t b, uint32_t ka, uint32_t kb)
+{
+    uint32_t even = (((a & LANES) * ka + (b & LANES) * kb) >> 8) & LANES;
+    uint32_t odd = (((a >> 8) & LANES) * ka + ((b >> 8) & LANES) * kb) & ~LANES;
+    return even | odd;
+}
+
+void rgb_array_scale(rgb_t *leds, size_t num, uint8_t scale)
+{
+    uint8_t *p = (uint8_t *)leds;
+    size_t len = num * sizeof(rgb_t);
+    uint32_t s = 1 + (uint32_t)scale;
+
+    for (; len >= 4; len -= 4, p += 4)
+        store32(p, scale8x4(load32(p), s));
+    for (; len; len--, p++)
+        *p = scale8(*p, scale);
+}
+
+void rgb_array_fade(rgb_t *leds, size_t num, uint8_t fade)
+{
+    rgb_array_scale(leds, num, ~fade);
+}
+
+void rgb_array_add(rgb_t *dst, const rgb_t *src, size_t num)
+{
+    uint8_t *d = (uint8_t *)dst;
+    const uint8_t *s = (const uint8_t *)src;
+    size_t len = num * sizeof(rgb_t);
+
+    for (; len >= 4; len -= 4, d += 4, s += 4)
+        store32(d, qadd8x4(load32(d), load32(s)));
+    for (; len; len--, d++, s++)
+        *d = qadd8(*d, *s);
+}
+
+void rgb_array_blend(rgb_t *dst, const rgb_t *overlay, size_t num, fract8 amount)
+{
+    uint8_t *d = (uint8_t *)dst;
+    const uint8_t *s = (const uint8_t *)overlay;
+    size_t len = num * sizeof(rgb_t);
+    uint32_t ka = 256 - (uint32_t)amount;
+    uint32_t kb = 1 + (uint32_t)amount;
+
+    for (; len >= 4; len -= 4, d += 4, s += 4)
+        store32(d, blend8x4(load32(d), load32(s), ka, kb));
+    for (; len; len--, d++, s++)
+        *d = blend8(*d, *s, amount);
+}
+
+void rgb_array_map(rgb_t *leds, size_t num, const uint8_t *lut)
+{
+    uint8_t *p = (uint8_t *)leds;
+    size_t len = num * sizeof(rgb_t);
+
+    for (; len >= 4; len -= 4, p += 4)
+    {
+        p[0] = lut[p[0]];
+        p[1] = lut[p[1]];
+        p[2] = lut[p[2]];
+        p[3] = lut[p[3]];
+    }
+    for (; len; len--, p++)
+        *p = lut[*p];
+}
+
+void rgb_array_gamma(rgb_t *leds, size_t num, float gamma)
+{
+    uint8_t lut[256];
+
+    for (int i = 0; i < 256; i++)
+        lut[i] = apply_gamma2brightness(i, gamma);
+    rgb_array_map(leds, num, lut);
+}
+
+static void build_channel(uint8_t *table, float gamma, uint8_t scale)
+{
+    for (int i = 0; i < 256; i++)
+    {
+        uint8_t v = gamma == 1.0f ? i : apply_gamma2brightness(i, gamma);
+        table[i] = scale != 255 ? scale8_video(v, scale) : v;
+    }
+}
+
+void rgb_lut_init(rgb_lut_t *lut, float gamma_r, float gamma_g, float gamma_b, rgb_t correction, uint8_t brightness)
+{
+    if (!lut)
+        return;
+
+    build_channel(lut->r, gamma_r, scale8_video(correction.r, brightness));
+    build_channel(lut->g, gamma_g, scale8_video(correction.g, brightness));
+    build_channel(lut->b, gamma_b, scale8_video(correction.b, brightness));
+}
+
+void rgb_array_apply_lut(rgb_t *leds, size_t num, const rgb_lut_t *lut)
+{
+    for (; num; num--, leds++)
+        *leds = rgb_lut_apply(lut, *leds);
+}
@@ -0,0 +1,158 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2021 Ruslan V. Uss <unclerus@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file rgb_array.h
+ * @defgroup rgb_array rgb_array
+ * @{
+ *
+ * Bulk operations on arrays of RGB colors
+ *
+ * All channels are processed the same way, so arrays are handled as plain
+ * byte strings, four channels per 32-bit word. Results are bit-exact with
+ * the corresponding per-pixel functions from rgb.h.
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#ifndef __COLOR_RGB_ARRAY_H__
+#define __COLOR_RGB_ARRAY_H__
+
+#include <stddef.h>
+#include "rgb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Per-channel lookup tables for gamma correction, color correction and
+ * brightness, see ::rgb_lut_init()
+ */
+typedef struct
+{
+    uint8_t r[256];
+    uint8_t g[256];
+    uint8_t b[256];
+} rgb_lut_t;
+
+/**
+ * @brief Build per-channel lookup tables
+ *
+ * Each table entry is gamma-adjusted like apply_gamma2brightness(), then
+ * scaled by the channel of `correction` and by `brightness` with
+ * scale8_video(). Building tables takes 768 powf() calls, so do it once and
+ * rebuild only when parameters change.
+ *
+ * @param lut        Tables to build
+ * @param gamma_r    Gamma for red channel, 1.0 for none
+ * @param gamma_g    Gamma for green channel, 1.0 for none
+ * @param gamma_b    Gamma for blue channel, 1.0 for none
+ * @param correction Color correction/temperature, `{ 255, 255, 255 }` for none
+ * @param brightness Global brightness, 255 for full
+ */
+void rgb_lut_init(rgb_lut_t *lut, float gamma_r, float gamma_g, float gamma_b, rgb_t correction, uint8_t brightness);
+
+/**
+ * @brief Apply lookup tables to single color
+ */
+static inline rgb_t rgb_lut_apply(const rgb_lut_t *lut, rgb_t c)
+{
+    rgb_t res = {
+        .r = lut->r[c.r],
+        .g = lut->g[c.g],
+        .b = lut->b[c.b],
+    };
+    return res;
+}
+
+/**
+ * @brief Apply lookup tables to array of colors
+ *
+ * @param leds   Array of colors
+ * @param num    Number of colors
+ * @param lut    Lookup tables
+ */
+void rgb_array_apply_lut(rgb_t *leds, size_t num, const rgb_lut_t *lut);
+
+/**
+ * @brief Scale down colors of array, same as rgb_scale() for each element
+ *
+ * @param leds   Array of colors
+ * @param num    Number of colors
+ * @param scale  Scale, 0..255
+ */
+void rgb_array_scale(rgb_t *leds, size_t num, uint8_t scale);
+
+/**
+ * @brief Fade colors of array, same as rgb_fade() for each element
+ *
+ * @param leds   Array of colors
+ * @param num    Number of colors
+ * @param fade   Amount of fading, 0..255
+ */
+void rgb_array_fade(rgb_t *leds, size_t num, uint8_t fade);
+
+/**
+ * @brief Add colors of one array to another, same as rgb_add_rgb()
+ *
+ * @param dst    Destination array
+ * @param src    Source array
+ * @param num    Number of colors
+ */
+void rgb_array_add(rgb_t *dst, const rgb_t *src, size_t num);
+
+/**
+ * @brief Blend one array over another, same as rgb_blend()
+ *
+ * @param dst     Destination array (existing colors)
+ * @param overlay Overlay array
+ * @param num     Number of colors
+ * @param amount  Amount of overlay, 0..255
+ */
+void rgb_array_blend(rgb_t *dst, const rgb_t *overlay, size_t num, fract8 amount);
+
+/**
+ * @brief Replace every channel of every color using lookup table
+ *
+ * @param leds   Array of colors
+ * @param num    Number of colors
+ * @param lut    Table of 256 channel values
+ */
+void rgb_array_map(rgb_t *leds, size_t num, const uint8_t *lut);
+
+/**
+ * @brief Gamma-adjust colors of array, same as apply_gamma2rgb()
+ *
+ * @param leds   Array of colors
+ * @param num    Number of colors
+ * @param gamma  Gamma value
+ */
+void rgb_array_gamma(rgb_t *leds, size_t num, float gamma);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**@}*/
+
+#endif /* __COLOR_RGB_ARRAY_H__ */
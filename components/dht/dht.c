@@ -41,8 +41,12 @@
 #include "dht.h"
 
 #include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
 #include <string.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <ets_sys.h>
 #include <esp_idf_lib_helpers.h>
 
@@ -51,6 +55,18 @@
 #define DHT_DATA_BITS 40
 #define DHT_DATA_BYTES (DHT_DATA_BITS / 8)
 
+// Edges captured by interrupt-driven reader: release of the line by MCU,
+// phases 'B', 'C' and 'D' and two edges per data bit
+#define DHT_EDGES (4 + DHT_DATA_BITS * 2)
+// Time for the sensor to transmit response after the line is released, ms
+#define DHT_RESPONSE_TIMEOUT_MS 10
+// Start pulse of interrupt-driven reader: at least 18 ms for DHT11,
+// rounded up to whole ticks plus one for the partial current tick,
+// 1-20 ms for AM2301 and at least 500 us for Si7021
+#define DHT11_START_TICKS ((18 * configTICK_RATE_HZ + 999) / 1000 + 1)
+#define AM2301_START_US 1100
+#define SI7021_START_US 500
+
 /*
  *  Note:
  *  A suitable pull-up resistor should be connected to the selected GPIO line
@@ -85,10 +101,12 @@ static const char *TAG = "dht";
 static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
 #define PORT_ENTER_CRITICAL() portENTER_CRITICAL(&mux)
 #define PORT_EXIT_CRITICAL() portEXIT_CRITICAL(&mux)
+#define OPEN_DRAIN_MODE GPIO_MODE_INPUT_OUTPUT_OD
 
 #elif HELPER_TARGET_IS_ESP8266
 #define PORT_ENTER_CRITICAL() portENTER_CRITICAL()
 #define PORT_EXIT_CRITICAL() portEXIT_CRITICAL()
+#define OPEN_DRAIN_MODE GPIO_MODE_OUTPUT_OD
 #endif
 
 #define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
@@ -200,11 +218,297 @@ static inline int16_t dht_convert_data(dht_sensor_type_t sensor_type, uint8_t ms
     return data;
 }
 
+/**
+ * Verify checksum and convert raw data.
+ */
+static esp_err_t dht_parse_data(dht_sensor_type_t sensor_type, const uint8_t data[DHT_DATA_BYTES],
+        int16_t *humidity, int16_t *temperature)
+{
+    if (data[4] != ((data[0] + data[1] + data[2] + data[3]) & 0xFF))
+    {
+        ESP_LOGE(TAG, "Checksum failed, invalid data received from sensor");
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    if (humidity)
+        *humidity = dht_convert_data(sensor_type, data[0], data[1]);
+    if (temperature)
+        *temperature = dht_convert_data(sensor_type, data[2], data[3]);
+
+    ESP_LOGD(TAG, "Sensor data: humidity=%d, temp=%d",
+            dht_convert_data(sensor_type, data[0], data[1]), dht_convert_data(sensor_type, data[2], data[3]));
+
+    return ESP_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Interrupt-driven reader
+
+typedef struct
+{
+    dht_async_t *req;
+    TaskHandle_t worker;
+    volatile size_t edges;
+    uint32_t time[DHT_EDGES];
+} capture_t;
+
+static QueueHandle_t queue = NULL;
+static capture_t captures[CONFIG_DHT_ASYNC_MAX_BATCH];
+
+#if HELPER_TARGET_IS_ESP32
+static void IRAM_ATTR edge_isr(void *arg)
+#elif HELPER_TARGET_IS_ESP8266
+static void edge_isr(void *arg)
+#endif
+{
+    capture_t *c = (capture_t *)arg;
+
+    if (c->edges >= DHT_EDGES)
+        return;
+    c->time[c->edges++] = (uint32_t)esp_timer_get_time();
+    if (c->edges < DHT_EDGES)
+        return;
+
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(c->worker, &woken);
+    if (woken == pdTRUE)
+        portYIELD_FROM_ISR();
+}
+
+/**
+ * Decode captured edges. Data bits are decoded from the end of the capture,
+ * so the read is valid even if release of the line by MCU was not captured.
+ */
+static esp_err_t decode_capture(const capture_t *c, uint8_t data[DHT_DATA_BYTES])
+{
+    size_t edges = c->edges;
+    if (edges < DHT_EDGES - 1)
+    {
+        ESP_LOGE(TAG, "Timeout on pin %d, %u edges captured", c->req->pin, (unsigned)edges);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    // falling edge of phase 'D', start of the first bit
+    const uint32_t *t = c->time + edges - DHT_DATA_BITS * 2 - 1;
+    memset(data, 0, DHT_DATA_BYTES);
+    for (int i = 0; i < DHT_DATA_BITS; i++)
+    {
+        uint32_t low_duration = t[i * 2 + 1] - t[i * 2];
+        uint32_t high_duration = t[i * 2 + 2] - t[i * 2 + 1];
+        data[i / 8] |= (high_duration > low_duration) << (7 - i % 8);
+    }
+
+    return ESP_OK;
+}
+
+static void complete(dht_async_t *req, esp_err_t result)
+{
+    // Callback may reuse the request, so copy everything needed first
+    TaskHandle_t notify_task = req->notify_task;
+    dht_async_cb_t callback = req->callback;
+
+    req->result = result;
+    req->done = true;
+
+    if (callback)
+        callback(req);
+    if (notify_task)
+        xTaskNotifyGive(notify_task);
+}
+
+static void read_batch(dht_sensor_type_t sensor_type, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        gpio_num_t pin = captures[i].req->pin;
+        captures[i].worker = xTaskGetCurrentTaskHandle();
+        captures[i].edges = 0;
+        gpio_set_intr_type(pin, GPIO_INTR_DISABLE);
+        gpio_set_direction(pin, OPEN_DRAIN_MODE);
+        gpio_set_level(pin, 1);
+        gpio_isr_handler_add(pin, edge_isr, &captures[i]);
+    }
+
+    // Phase 'A'. Lines are captured from the start of the pulse, so release
+    // of the line by MCU is the first captured edge.
+    for (size_t i = 0; i < count; i++)
+    {
+        gpio_set_level(captures[i].req->pin, 0);
+        gpio_set_intr_type(captures[i].req->pin, GPIO_INTR_ANYEDGE);
+    }
+    if (sensor_type == DHT_TYPE_DHT11)
+        vTaskDelay(DHT11_START_TICKS);
+    else
+        ets_delay_us(sensor_type == DHT_TYPE_AM2301 ? AM2301_START_US : SI7021_START_US);
+    for (size_t i = 0; i < count; i++)
+        gpio_set_level(captures[i].req->pin, 1);
+
+    // Wait until all sensors transmit their data
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(DHT_RESPONSE_TIMEOUT_MS) + 1;
+    size_t completed = 0;
+    while (completed < count)
+    {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout || !ulTaskNotifyTake(pdFALSE, timeout - elapsed))
+            break;
+        completed++;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        gpio_num_t pin = captures[i].req->pin;
+        gpio_set_intr_type(pin, GPIO_INTR_DISABLE);
+        gpio_isr_handler_remove(pin);
+        gpio_set_direction(pin, GPIO_MODE_OUTPUT_OD);
+        gpio_set_level(pin, 1);
+    }
+    // Drop notifications of captures completed after the timeout
+    ulTaskNotifyTake(pdTRUE, 0);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        dht_async_t *req = captures[i].req;
+        uint8_t data[DHT_DATA_BYTES];
+        esp_err_t res = decode_capture(&captures[i], data);
+        if (res == ESP_OK)
+            res = dht_parse_data(sensor_type, data, &req->humidity, &req->temperature);
+        complete(req, res);
+    }
+}
+
+static void async_worker(void *arg)
+{
+    QueueHandle_t q = (QueueHandle_t)arg;
+    dht_async_t *req;
+
+    while (true)
+    {
+        if (xQueueReceive(q, &req, portMAX_DELAY) != pdTRUE)
+            continue;
+
+        dht_sensor_type_t sensor_type = req->sensor_type;
+        size_t count = 0;
+        captures[count++].req = req;
+
+        // Collect queued requests for sensors of the same type on other pins.
+        // Worker is the only reader of the queue, so the peeked request is
+        // the one received then.
+        while (count < CONFIG_DHT_ASYNC_MAX_BATCH && xQueuePeek(q, &req, 0) == pdTRUE)
+        {
+            bool busy = req->sensor_type != sensor_type;
+            for (size_t i = 0; i < count && !busy; i++)
+                busy = captures[i].req->pin == req->pin;
+            if (busy)
+                break;
+            xQueueReceive(q, &req, 0);
+            captures[count++].req = req;
+        }
+
+        read_batch(sensor_type, count);
+    }
+}
+
+static esp_err_t async_start()
+{
+    esp_err_t res = gpio_install_isr_service(0);
+    if (res != ESP_OK && res != ESP_ERR_INVALID_STATE)
+        return res;
+
+    // Worker is started before the queue is published, so requests
+    // are never submitted to a queue without a reader
+    QueueHandle_t q = xQueueCreate(CONFIG_DHT_ASYNC_QUEUE_SIZE, sizeof(dht_async_t *));
+    if (!q)
+        return ESP_ERR_NO_MEM;
+    TaskHandle_t task;
+    if (xTaskCreate(async_worker, "dht", CONFIG_DHT_ASYNC_TASK_STACK_SIZE, q,
+            CONFIG_DHT_ASYNC_TASK_PRIORITY, &task) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Could not start asynchronous worker");
+        vQueueDelete(q);
+        return ESP_ERR_NO_MEM;
+    }
+
+    bool published = false;
+    PORT_ENTER_CRITICAL();
+    if (!queue)
+    {
+        queue = q;
+        published = true;
+    }
+    PORT_EXIT_CRITICAL();
+
+    if (published)
+        ESP_LOGD(TAG, "Asynchronous worker started");
+    else
+    {
+        // Another task started the worker meanwhile, ours is still
+        // waiting for the first request on the empty queue
+        vTaskDelete(task);
+        vQueueDelete(q);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t dht_submit(dht_async_t *req)
+{
+    CHECK_ARG(req && req->sensor_type <= DHT_TYPE_SI7021 && req->pin < GPIO_NUM_MAX);
+
+    if (!queue)
+    {
+        esp_err_t res = async_start();
+        if (res != ESP_OK)
+            return res;
+    }
+
+    req->done = false;
+    req->result = ESP_FAIL;
+
+    return xQueueSend(queue, &req, 0) == pdTRUE ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+#if CONFIG_DHT_READ_ASYNC
+static void read_done(dht_async_t *req)
+{
+    xSemaphoreGive((SemaphoreHandle_t)req->ctx);
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
 esp_err_t dht_read_data(dht_sensor_type_t sensor_type, gpio_num_t pin,
         int16_t *humidity, int16_t *temperature)
 {
     CHECK_ARG(humidity || temperature);
 
+#if CONFIG_DHT_READ_ASYNC
+    // Private semaphore leaves task notifications of the caller untouched
+    SemaphoreHandle_t done = xSemaphoreCreateBinary();
+    if (!done)
+        return ESP_ERR_NO_MEM;
+    dht_async_t req = {
+        .sensor_type = sensor_type,
+        .pin = pin,
+        .callback = read_done,
+        .ctx = done,
+    };
+    esp_err_t result = dht_submit(&req);
+    if (result == ESP_OK)
+        xSemaphoreTake(done, portMAX_DELAY);
+    vSemaphoreDelete(done);
+    if (result != ESP_OK)
+        return result;
+    if (req.result != ESP_OK)
+        return req.result;
+
+    if (humidity)
+        *humidity = req.humidity;
+    if (temperature)
+        *temperature = req.temperature;
+
+    return ESP_OK;
+#else
     uint8_t data[DHT_DATA_BYTES] = { 0 };
 
     gpio_set_direction(pin, GPIO_MODE_OUTPUT_OD);
@@ -223,20 +527,8 @@ esp_err_t dht_read_data(dht_sensor_type_t sensor_type, gpio_num_t pin,
     if (result != ESP_OK)
         return result;
 
-    if (data[4] != ((data[0] + data[1] + data[2] + data[3]) & 0xFF))
-    {
-        ESP_LOGE(TAG, "Checksum failed, invalid data received from sensor");
-        return ESP_ERR_INVALID_CRC;
-    }
-
-    if (humidity)
-        *humidity = dht_convert_data(sensor_type, data[0], data[1]);
-    if (temperature)
-        *temperature = dht_convert_data(sensor_type, data[2], data[3]);
-
-    ESP_LOGD(TAG, "Sensor data: humidity=%d, temp=%d", *humidity, *temperature);
-
-    return ESP_OK;
+    return dht_parse_data(sensor_type, data, humidity, temperature);
+#endif
 }
 
 esp_err_t dht_read_float_data(dht_sensor_type_t sensor_type, gpio_num_t pin,
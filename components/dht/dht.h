@@ -46,7 +46,10 @@
 #ifndef __DHT_H__
 #define __DHT_H__
 
+#include <stdbool.h>
 #include <driver/gpio.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include <esp_err.h>
 
 #ifdef __cplusplus
@@ -63,9 +66,41 @@ typedef enum
     DHT_TYPE_SI7021       //!< Itead Si7021
 } dht_sensor_type_t;
 
+typedef struct dht_async dht_async_t;
+
+/**
+ * Asynchronous read completion callback.
+ *
+ * Called from the DHT worker task, must not block for long.
+ */
+typedef void (*dht_async_cb_t)(dht_async_t *req);
+
+/**
+ * Asynchronous read request
+ *
+ * Request must stay valid until it is completed.
+ */
+struct dht_async
+{
+    dht_sensor_type_t sensor_type; //!< Sensor type
+    gpio_num_t pin;                //!< GPIO pin connected to sensor OUT
+    dht_async_cb_t callback;       //!< Completion callback, may be NULL
+    void *ctx;                     //!< User context
+    TaskHandle_t notify_task;      //!< Task to notify with xTaskNotifyGive() on completion, may be NULL
+    int16_t humidity;              //!< Humidity, percents * 10, valid if result is ESP_OK
+    int16_t temperature;           //!< Temperature, degrees Celsius * 10, valid if result is ESP_OK
+    volatile bool done;            //!< true when request is completed
+    volatile esp_err_t result;     //!< Read result, valid when done is true
+};
+
 /**
  * @brief Read integer data from sensor on specified pin
  *
+ * If CONFIG_DHT_READ_ASYNC is enabled, request is executed by the DHT
+ * worker task (see ::dht_submit()) and the caller sleeps until it is
+ * completed, otherwise sensor is read by polling the pin with interrupts
+ * disabled.
+ *
  * Humidity and temperature are returned as integers.
  * For example: humidity=625 is 62.5 %, temperature=244 is 24.4 degrees Celsius
  *
@@ -92,6 +127,29 @@ esp_err_t dht_read_data(dht_sensor_type_t sensor_type, gpio_num_t pin,
 esp_err_t dht_read_float_data(dht_sensor_type_t sensor_type, gpio_num_t pin,
         float *humidity, float *temperature);
 
+/**
+ * @brief Queue sensor read for asynchronous execution
+ *
+ * Request is executed by the DHT worker task, which is created on first call.
+ * Worker reads up to CONFIG_DHT_ASYNC_MAX_BATCH queued sensors of the same type
+ * at once: start pulse is generated on all their pins simultaneously (the worker
+ * sleeps during 18 ms pulse of DHT11 and busy-waits during ~1 ms pulse of
+ * AM2301 and Si7021), response edges are timestamped in GPIO interrupt handler
+ * and decoded by the worker. CPU is not blocked while data is transmitted.
+ *
+ * When request is completed, `req->done` is set, `req->callback` is called
+ * and `req->notify_task` is notified. Notifications are counting, so a task
+ * that submitted N requests can wait for them with N calls of ulTaskNotifyTake().
+ *
+ * @note GPIO ISR service is installed by this function if it is not
+ *       installed yet. Sensor pins must not be used with dht_read_data()
+ *       while requests for them are pending.
+ *
+ * @param req Asynchronous read request
+ * @return `ESP_OK` on success, `ESP_ERR_TIMEOUT` if the queue is full
+ */
+esp_err_t dht_submit(dht_async_t *req);
+
 #ifdef __cplusplus
 }
 #endif
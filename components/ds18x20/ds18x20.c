@@ -42,9 +42,13 @@
  */
 
 #include <math.h>
+#include <string.h>
+#include <inttypes.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <freertos/semphr.h>
 #include <esp_idf_lib_helpers.h>
 #include "ds18x20.h"
 
@@ -64,110 +68,246 @@
 #define CHECK(x) do { esp_err_t __; if ((__ = x) != ESP_OK) return __; } while (0)
 #define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
 
-#if HELPER_TARGET_IS_ESP32
-static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
-#define PORT_ENTER_CRITICAL portENTER_CRITICAL(&mux)
-#define PORT_EXIT_CRITICAL portEXIT_CRITICAL(&mux)
+static const char *TAG = "ds18x20";
+
+// DS18B20 configuration register: 0 R1 R0 1 1 1 1 1
+#define DS18B20_CONFIG(res) (((res) << 5) | 0x1f)
+#define DS18B20_CONFIG_RES(cfg) (((cfg) >> 5) & 0x03)
+
+#define MAX_CONVERSION_TIME_MS 750
+
+// Conversion time for each DS18B20 resolution, ms
+static const uint16_t conversion_time_ms[] = { 94, 188, 375, MAX_CONVERSION_TIME_MS };
 
+// Known resolutions of DS18B20 devices
+typedef struct
+{
+    gpio_num_t pin;
+    ds18x20_addr_t addr;
+    ds18b20_resolution_t resolution;
+} res_cache_t;
+
+// Cache is shared by all buses and tasks, ROM addresses are unique
+// so entries are looked up by address only. Empty entries have zero
+// address with invalid family code.
+static res_cache_t res_cache[CONFIG_DS18X20_RESOLUTION_CACHE_SIZE] = { 0 };
+static size_t res_cache_next = 0;
+
+#if HELPER_TARGET_IS_ESP32
+static portMUX_TYPE res_cache_mux = portMUX_INITIALIZER_UNLOCKED;
+#define RES_CACHE_LOCK() portENTER_CRITICAL(&res_cache_mux)
+#define RES_CACHE_UNLOCK() portEXIT_CRITICAL(&res_cache_mux)
 #elif HELPER_TARGET_IS_ESP8266
-#define PORT_ENTER_CRITICAL portENTER_CRITICAL()
-#define PORT_EXIT_CRITICAL portEXIT_CRITICAL()
+#define RES_CACHE_LOCK() portENTER_CRITICAL()
+#define RES_CACHE_UNLOCK() portEXIT_CRITICAL()
 #endif
 
-static const char *TAG = "ds18x20";
+// Must be called with cache locked
+static res_cache_t *res_cache_find(ds18x20_addr_t addr)
+{
+    for (size_t i = 0; i < CONFIG_DS18X20_RESOLUTION_CACHE_SIZE; i++)
+        if (res_cache[i].addr == addr)
+            return &res_cache[i];
+    return NULL;
+}
 
-esp_err_t ds18x20_measure(gpio_num_t pin, ds18x20_addr_t addr, bool wait)
+static bool res_cache_get(ds18x20_addr_t addr, ds18b20_resolution_t *resolution)
+{
+    RES_CACHE_LOCK();
+    res_cache_t *entry = res_cache_find(addr);
+    if (entry)
+        *resolution = entry->resolution;
+    RES_CACHE_UNLOCK();
+
+    return entry != NULL;
+}
+
+static void res_cache_update(gpio_num_t pin, ds18x20_addr_t addr, uint8_t config)
+{
+    ds18b20_resolution_t resolution = DS18B20_CONFIG_RES(config);
+    if (addr != DS18X20_ANY && (uint8_t)addr != DS18B20_FAMILY_ID)
+        return;
+
+    RES_CACHE_LOCK();
+    if (addr == DS18X20_ANY)
+    {
+        // all devices on this bus got the same configuration
+        for (size_t i = 0; i < CONFIG_DS18X20_RESOLUTION_CACHE_SIZE; i++)
+            if (res_cache[i].pin == pin && (uint8_t)res_cache[i].addr == DS18B20_FAMILY_ID)
+                res_cache[i].resolution = resolution;
+    }
+    else
+    {
+        res_cache_t *entry = res_cache_find(addr);
+        if (!entry)
+        {
+            // replace the oldest entry
+            entry = &res_cache[res_cache_next];
+            res_cache_next = (res_cache_next + 1) % CONFIG_DS18X20_RESOLUTION_CACHE_SIZE;
+            entry->addr = addr;
+        }
+        entry->pin = pin;
+        entry->resolution = resolution;
+    }
+    RES_CACHE_UNLOCK();
+}
+
+// Reset bus, address device and send command in one bus transfer
+static esp_err_t send_command(gpio_num_t pin, ds18x20_addr_t addr, uint8_t cmd, size_t *len, uint8_t *buf)
 {
     if (!onewire_reset(pin))
         return ESP_ERR_INVALID_RESPONSE;
 
+    size_t n = 0;
     if (addr == DS18X20_ANY)
-        onewire_skip_rom(pin);
+        buf[n++] = ds18x20_SKIP_ROM;
     else
-        onewire_select(pin, addr);
+    {
+        buf[n++] = ds18x20_MATCHROM;
+        for (int i = 0; i < 8; i++, addr >>= 8)
+            buf[n++] = addr & 0xff;
+    }
+    buf[n++] = cmd;
+    *len = n;
+
+    return ESP_OK;
+}
+
+// Send command, last byte is written with strong pull-up for parasitic devices
+static esp_err_t send_power_command(gpio_num_t pin, ds18x20_addr_t addr, uint8_t cmd)
+{
+    uint8_t buf[10];
+    size_t len;
 
-    PORT_ENTER_CRITICAL;
-    onewire_write(pin, ds18x20_CONVERT_T);
+    CHECK(send_command(pin, addr, cmd, &len, buf));
     // For parasitic devices, power must be applied within 10us after issuing
-    // the convert command.
-    onewire_power(pin);
-    PORT_EXIT_CRITICAL;
+    // the command.
+    if (!onewire_write_bytes(pin, buf, len - 1) || !onewire_write_power(pin, cmd))
+        return ESP_ERR_INVALID_RESPONSE;
 
-    if (wait)
+    return ESP_OK;
+}
+
+// Read scratchpad with CRC in one transfer
+static esp_err_t read_scratchpad(gpio_num_t pin, ds18x20_addr_t addr, uint8_t *buffer)
+{
+    uint8_t buf[10];
+    size_t len;
+
+    CHECK(send_command(pin, addr, ds18x20_READ_SCRATCHPAD, &len, buf));
+    if (!onewire_write_bytes(pin, buf, len) || !onewire_read_bytes(pin, buffer, 9))
+        return ESP_ERR_INVALID_RESPONSE;
+
+    uint8_t expected_crc = onewire_crc8(buffer, 8);
+    if (buffer[8] != expected_crc)
     {
-        SLEEP_MS(750);
-        onewire_depower(pin);
+        ESP_LOGE(TAG, "CRC check failed reading scratchpad: %02x %02x %02x %02x %02x %02x %02x %02x : %02x (expected %02x)", buffer[0], buffer[1],
+                buffer[2], buffer[3], buffer[4], buffer[5], buffer[6], buffer[7], buffer[8], expected_crc);
+        return ESP_ERR_INVALID_CRC;
     }
+    if (addr != DS18X20_ANY)
+        res_cache_update(pin, addr, buffer[4]);
 
     return ESP_OK;
 }
 
-esp_err_t ds18x20_read_scratchpad(gpio_num_t pin, ds18x20_addr_t addr, uint8_t *buffer)
+static float ds18b20_temperature(const uint8_t *scratchpad)
 {
-    CHECK_ARG(buffer);
+    int16_t temp = scratchpad[1] << 8 | scratchpad[0];
 
-    uint8_t crc;
-    uint8_t expected_crc;
+    return ((float)temp * 625.0) / 10000;
+}
 
-    if (!onewire_reset(pin))
-        return ESP_ERR_INVALID_RESPONSE;
+static float ds18s20_temperature(const uint8_t *scratchpad)
+{
+    int16_t temp = scratchpad[1] << 8 | scratchpad[0];
 
-    if (addr == DS18X20_ANY)
-        onewire_skip_rom(pin);
-    else
-        onewire_select(pin, addr);
-    onewire_write(pin, ds18x20_READ_SCRATCHPAD);
+    temp = ((temp & 0xfffe) << 3) + (16 - scratchpad[6]) - 4;
+    return ((float)temp * 625.0) / 10000 - 0.25;
+}
 
-    for (int i = 0; i < 8; i++)
-        buffer[i] = onewire_read(pin);
-    crc = onewire_read(pin);
+esp_err_t ds18x20_measure(gpio_num_t pin, ds18x20_addr_t addr, bool wait)
+{
+    CHECK(send_power_command(pin, addr, ds18x20_CONVERT_T));
 
-    expected_crc = onewire_crc8(buffer, 8);
-    if (crc != expected_crc)
+    if (wait)
     {
-        ESP_LOGE(TAG, "CRC check failed reading scratchpad: %02x %02x %02x %02x %02x %02x %02x %02x : %02x (expected %02x)", buffer[0], buffer[1],
-                buffer[2], buffer[3], buffer[4], buffer[5], buffer[6], buffer[7], crc, expected_crc);
-        return ESP_ERR_INVALID_CRC;
+        SLEEP_MS(addr == DS18X20_ANY ? MAX_CONVERSION_TIME_MS : ds18x20_conversion_time(addr));
+        onewire_depower(pin);
     }
 
     return ESP_OK;
 }
 
-esp_err_t ds18x20_write_scratchpad(gpio_num_t pin, ds18x20_addr_t addr, uint8_t *buffer)
+uint32_t ds18x20_conversion_time(ds18x20_addr_t addr)
 {
-    CHECK_ARG(buffer);
+    if ((uint8_t)addr != DS18B20_FAMILY_ID)
+        return MAX_CONVERSION_TIME_MS;
 
-    if (!onewire_reset(pin))
-        return ESP_ERR_INVALID_RESPONSE;
+    ds18b20_resolution_t resolution;
+    return res_cache_get(addr, &resolution) ? conversion_time_ms[resolution] : MAX_CONVERSION_TIME_MS;
+}
 
-    if (addr == DS18X20_ANY)
-        onewire_skip_rom(pin);
-    else
-        onewire_select(pin, addr);
-    onewire_write(pin, ds18x20_WRITE_SCRATCHPAD);
+esp_err_t ds18b20_get_resolution(gpio_num_t pin, ds18x20_addr_t addr, ds18b20_resolution_t *resolution)
+{
+    CHECK_ARG(resolution && (uint8_t)addr == DS18B20_FAMILY_ID && addr != DS18X20_ANY);
 
-    for (int i = 0; i < 3; i++)
-        onewire_write(pin, buffer[i]);
+    if (res_cache_get(addr, resolution))
+        return ESP_OK;
+
+    uint8_t scratchpad[9];
+    CHECK(read_scratchpad(pin, addr, scratchpad));
+    *resolution = DS18B20_CONFIG_RES(scratchpad[4]);
 
     return ESP_OK;
 }
 
-esp_err_t ds18x20_copy_scratchpad(gpio_num_t pin, ds18x20_addr_t addr)
+esp_err_t ds18b20_set_resolution(gpio_num_t pin, ds18x20_addr_t addr, ds18b20_resolution_t resolution)
 {
-    if (!onewire_reset(pin))
+    CHECK_ARG((uint8_t)addr == DS18B20_FAMILY_ID && addr != DS18X20_ANY && resolution <= DS18B20_RESOLUTION_12_BIT);
+
+    // keep alarm thresholds
+    uint8_t scratchpad[9];
+    CHECK(read_scratchpad(pin, addr, scratchpad));
+    if (DS18B20_CONFIG_RES(scratchpad[4]) == resolution)
+        return ESP_OK;
+
+    scratchpad[4] = DS18B20_CONFIG(resolution);
+    return ds18x20_write_scratchpad(pin, addr, scratchpad + 2);
+}
+
+esp_err_t ds18x20_read_scratchpad(gpio_num_t pin, ds18x20_addr_t addr, uint8_t *buffer)
+{
+    CHECK_ARG(buffer);
+
+    uint8_t scratchpad[9];
+
+    CHECK(read_scratchpad(pin, addr, scratchpad));
+    memcpy(buffer, scratchpad, 8);
+
+    return ESP_OK;
+}
+
+esp_err_t ds18x20_write_scratchpad(gpio_num_t pin, ds18x20_addr_t addr, uint8_t *buffer)
+{
+    CHECK_ARG(buffer);
+
+    uint8_t buf[13];
+    size_t len;
+
+    CHECK(send_command(pin, addr, ds18x20_WRITE_SCRATCHPAD, &len, buf));
+    for (int i = 0; i < 3; i++)
+        buf[len++] = buffer[i];
+    if (!onewire_write_bytes(pin, buf, len))
         return ESP_ERR_INVALID_RESPONSE;
+    res_cache_update(pin, addr, buffer[2]);
 
-    if (addr == DS18X20_ANY)
-        onewire_skip_rom(pin);
-    else
-        onewire_select(pin, addr);
+    return ESP_OK;
+}
 
-    PORT_ENTER_CRITICAL;
-    onewire_write(pin, ds18x20_COPY_SCRATCHPAD);
-    // For parasitic devices, power must be applied within 10us after issuing
-    // the convert command.
-    onewire_power(pin);
-    PORT_EXIT_CRITICAL;
+esp_err_t ds18x20_copy_scratchpad(gpio_num_t pin, ds18x20_addr_t addr)
+{
+    CHECK(send_power_command(pin, addr, ds18x20_COPY_SCRATCHPAD));
 
     // And then it needs to keep that power up for 10ms.
     SLEEP_MS(10);
@@ -180,14 +320,10 @@ esp_err_t ds18b20_read_temperature(gpio_num_t pin, ds18x20_addr_t addr, float *t
 {
     CHECK_ARG(temperature);
 
-    uint8_t scratchpad[8];
-    int16_t temp;
-
-    CHECK(ds18x20_read_scratchpad(pin, addr, scratchpad));
+    uint8_t scratchpad[9];
 
-    temp = scratchpad[1] << 8 | scratchpad[0];
-
-    *temperature = ((float)temp * 625.0) / 10000;
+    CHECK(read_scratchpad(pin, addr, scratchpad));
+    *temperature = ds18b20_temperature(scratchpad);
 
     return ESP_OK;
 }
@@ -196,15 +332,10 @@ esp_err_t ds18s20_read_temperature(gpio_num_t pin, ds18x20_addr_t addr, float *t
 {
     CHECK_ARG(temperature);
 
-    uint8_t scratchpad[8];
-    int16_t temp;
-
-    CHECK(ds18x20_read_scratchpad(pin, addr, scratchpad));
+    uint8_t scratchpad[9];
 
-    temp = scratchpad[1] << 8 | scratchpad[0];
-
-    temp = ((temp & 0xfffe) << 3) + (16 - scratchpad[6]) - 4;
-    *temperature = ((float)temp * 625.0) / 10000 - 0.25;
+    CHECK(read_scratchpad(pin, addr, scratchpad));
+    *temperature = ds18s20_temperature(scratchpad);
 
     return ESP_OK;
 }
@@ -246,9 +377,24 @@ esp_err_t ds18x20_measure_and_read(gpio_num_t pin, ds18x20_addr_t addr, float *t
 
 esp_err_t ds18x20_measure_and_read_multi(gpio_num_t pin, ds18x20_addr_t *addr_list, size_t addr_count, float *result_list)
 {
-    CHECK_ARG(result_list && addr_count);
+    CHECK_ARG(addr_list && result_list && addr_count);
+
+    // Conversion is started on all devices on the bus. Parasite powered
+    // ones, listed or not, need strong pull-up for the longest conversion
+    // time, otherwise wait for the slowest of listed sensors only
+    bool parasite;
+    CHECK(ds18x20_parasite_powered(pin, DS18X20_ANY, &parasite));
+    uint32_t wait_ms = parasite ? MAX_CONVERSION_TIME_MS : 0;
+    for (size_t i = 0; i < addr_count && !parasite; i++)
+    {
+        uint32_t time_ms = ds18x20_conversion_time(addr_list[i]);
+        if (time_ms > wait_ms)
+            wait_ms = time_ms;
+    }
 
-    CHECK(ds18x20_measure(pin, DS18X20_ANY, true));
+    CHECK(ds18x20_measure(pin, DS18X20_ANY, false));
+    SLEEP_MS(wait_ms);
+    onewire_depower(pin);
 
     return ds18x20_read_temp_multi(pin, addr_list, addr_count, result_list);
 }
@@ -290,3 +436,158 @@ esp_err_t ds18x20_read_temp_multi(gpio_num_t pin, ds18x20_addr_t *addr_list, siz
     return res;
 }
 
+esp_err_t ds18x20_acquire(gpio_num_t pin, const ds18x20_addr_t *addr_list, size_t addr_count,
+        ds18x20_sample_cb_t callback, void *ctx)
+{
+    CHECK_ARG(addr_list && addr_count && callback);
+
+    // Parasite powered devices need strong pull-up until all of them have
+    // finished conversion, so bus can't be used in the meantime
+    bool parasite;
+    CHECK(ds18x20_parasite_powered(pin, DS18X20_ANY, &parasite));
+
+    // start conversion on all sensors at once
+    CHECK(send_power_command(pin, DS18X20_ANY, ds18x20_CONVERT_T));
+    int64_t start = esp_timer_get_time();
+
+    esp_err_t res = ESP_OK;
+    uint8_t scratchpad[9];
+    ds18x20_sample_t sample;
+
+    // read sensors grouped by conversion time, fastest first
+    for (size_t r = 0; r < sizeof(conversion_time_ms) / sizeof(conversion_time_ms[0]); r++)
+    {
+        uint32_t group_ms = conversion_time_ms[r];
+        bool group_ready = false;
+        for (size_t i = 0; i < addr_count; i++)
+        {
+            uint32_t time_ms = ds18x20_conversion_time(addr_list[i]);
+            if (parasite ? r != DS18B20_RESOLUTION_12_BIT : time_ms != group_ms)
+                continue;
+
+            if (!group_ready)
+            {
+                // task sleeps while conversion is in progress
+                int64_t elapsed_ms = (esp_timer_get_time() - start) / 1000;
+                if (elapsed_ms < group_ms)
+                    SLEEP_MS(group_ms - elapsed_ms);
+                onewire_depower(pin);
+                sample.timestamp = esp_timer_get_time();
+                group_ready = true;
+            }
+
+            sample.addr = addr_list[i];
+            sample.result = read_scratchpad(pin, sample.addr, scratchpad);
+            if (sample.result == ESP_OK)
+                sample.temperature = (uint8_t)sample.addr == DS18B20_FAMILY_ID
+                    ? ds18b20_temperature(scratchpad)
+                    : ds18s20_temperature(scratchpad);
+            else
+            {
+                sample.temperature = NAN;
+                res = sample.result;
+            }
+            callback(&sample, ctx);
+        }
+    }
+
+    return res;
+}
+
+static void acq_deliver(const ds18x20_sample_t *sample, void *ctx)
+{
+    ds18x20_acq_t *acq = (ds18x20_acq_t *)ctx;
+
+    if (acq->queue && xQueueSend(acq->queue, sample, 0) != pdTRUE)
+        ESP_LOGW(TAG, "Sample queue is full, sample of %08" PRIx32 "%08" PRIx32 " lost",
+                (uint32_t)(sample->addr >> 32), (uint32_t)sample->addr);
+    if (acq->callback)
+        acq->callback(sample, acq->ctx);
+}
+
+static void acq_task(void *arg)
+{
+    ds18x20_acq_t *acq = (ds18x20_acq_t *)arg;
+
+    TickType_t last = xTaskGetTickCount();
+    while (acq->running)
+    {
+        esp_err_t res = ds18x20_acquire(acq->pin, acq->addr_list, acq->addr_count, acq_deliver, acq);
+        if (res != ESP_OK)
+            ESP_LOGW(TAG, "Acquisition cycle failed: %d (%s)", res, esp_err_to_name(res));
+
+        // sleep until the next cycle, ds18x20_acq_stop() wakes the task up
+        TickType_t period = pdMS_TO_TICKS(acq->period_ms);
+        TickType_t elapsed = xTaskGetTickCount() - last;
+        if (acq->running && elapsed < period)
+            ulTaskNotifyTake(pdTRUE, period - elapsed);
+        last = xTaskGetTickCount();
+    }
+
+    // task is deleted by ds18x20_acq_stop()
+    xSemaphoreGive(acq->stopped);
+    vTaskSuspend(NULL);
+}
+
+esp_err_t ds18x20_acq_start(ds18x20_acq_t *acq)
+{
+    CHECK_ARG(acq && acq->addr_list && acq->addr_count && (acq->queue || acq->callback) && !acq->task);
+
+    acq->stopped = xSemaphoreCreateBinary();
+    if (!acq->stopped)
+        return ESP_ERR_NO_MEM;
+
+    acq->running = true;
+    if (xTaskCreate(acq_task, "ds18x20", CONFIG_DS18X20_ACQ_TASK_STACK_SIZE, acq,
+            CONFIG_DS18X20_ACQ_TASK_PRIORITY, &acq->task) != pdPASS)
+    {
+        acq->running = false;
+        acq->task = NULL;
+        vSemaphoreDelete(acq->stopped);
+        acq->stopped = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t ds18x20_acq_stop(ds18x20_acq_t *acq)
+{
+    CHECK_ARG(acq);
+
+    TaskHandle_t task = acq->task;
+    // the task would wait for itself
+    if (!task || task == xTaskGetCurrentTaskHandle())
+        return ESP_ERR_INVALID_STATE;
+
+    acq->running = false;
+    // task is suspended or alive until it is deleted here
+    xTaskNotifyGive(task);
+    xSemaphoreTake(acq->stopped, portMAX_DELAY);
+    vTaskDelete(task);
+
+    vSemaphoreDelete(acq->stopped);
+    acq->stopped = NULL;
+    acq->task = NULL;
+
+    return ESP_OK;
+}
+
+esp_err_t ds18x20_parasite_powered(gpio_num_t pin, ds18x20_addr_t addr, bool *parasite)
+{
+    CHECK_ARG(parasite);
+
+    uint8_t buf[10];
+    size_t len;
+
+    CHECK(send_command(pin, addr, ds18x20_READ_PWRSUPPLY, &len, buf));
+    if (!onewire_write_bytes(pin, buf, len))
+        return ESP_ERR_INVALID_RESPONSE;
+    // parasite powered devices pull the bus low during read time slot
+    int r = onewire_read(pin);
+    if (r < 0)
+        return ESP_ERR_INVALID_RESPONSE;
+    *parasite = !(r & 1);
+
+    return ESP_OK;
+}
@@ -47,6 +47,10 @@
 
 #include <esp_err.h>
 #include <onewire.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -63,6 +67,49 @@ typedef onewire_addr_t ds18x20_addr_t;
 /** Family ID (lower address byte) of DS18S20 sensors */
 #define DS18S20_FAMILY_ID 0x10
 
+/**
+ * DS18B20 resolution
+ */
+typedef enum {
+    DS18B20_RESOLUTION_9_BIT = 0, //!< 0.5 degrees, conversion time 93.75 ms
+    DS18B20_RESOLUTION_10_BIT,    //!< 0.25 degrees, conversion time 187.5 ms
+    DS18B20_RESOLUTION_11_BIT,    //!< 0.125 degrees, conversion time 375 ms
+    DS18B20_RESOLUTION_12_BIT,    //!< 0.0625 degrees, conversion time 750 ms (default)
+} ds18b20_resolution_t;
+
+/**
+ * Temperature sample
+ */
+typedef struct
+{
+    ds18x20_addr_t addr;   ///< Sensor address
+    float temperature;     ///< Temperature in degrees Celsius, NAN on error
+    esp_err_t result;      ///< Result of reading sensor
+    int64_t timestamp;     ///< End of conversion, microseconds since boot
+} ds18x20_sample_t;
+
+/**
+ * Sample callback prototype
+ */
+typedef void (*ds18x20_sample_cb_t)(const ds18x20_sample_t *sample, void *ctx);
+
+/**
+ * Periodic acquisition descriptor
+ */
+typedef struct
+{
+    gpio_num_t pin;                  ///< The GPIO pin connected to the ds18x20 bus
+    const ds18x20_addr_t *addr_list; ///< Sensors to read
+    size_t addr_count;               ///< Number of sensors in `addr_list`
+    uint32_t period_ms;              ///< Period of acquisition cycles, ms. 0 for back-to-back cycles
+    QueueHandle_t queue;             ///< Queue of ::ds18x20_sample_t to send samples to, can be NULL
+    ds18x20_sample_cb_t callback;    ///< Function to call for each sample, can be NULL
+    void *ctx;                       ///< Callback argument
+    TaskHandle_t task;               ///< Acquisition task, managed by driver
+    SemaphoreHandle_t stopped;       ///< Given by acquisition task on exit, managed by driver
+    volatile bool running;           ///< Acquisition is running, managed by driver
+} ds18x20_acq_t;
+
 /**
  * @brief Find the addresses of all ds18x20 devices on the bus.
  *
@@ -88,10 +135,11 @@ esp_err_t ds18x20_scan_devices(gpio_num_t pin, ds18x20_addr_t *addr_list, size_t
  * @brief Tell one or more sensors to perform a temperature measurement and
  * conversion (CONVERT_T) operation.
  *
- * This operation can take up to 750ms to complete.
+ * This operation can take up to 750ms to complete. Conversion time of
+ * DS18B20 depends on its resolution, see ::ds18x20_conversion_time().
  *
  * If `wait=true`, this routine will automatically drive the pin high for the
- * necessary 750ms after issuing the command to ensure parasitically-powered
+ * necessary time after issuing the command to ensure parasitically-powered
  * devices have enough power to perform the conversion operation (for
  * non-parasitically-powered devices, this is not necessary but does not
  * hurt). If `wait=false`, this routine will drive the pin high, but will
@@ -214,6 +262,10 @@ esp_err_t ds18x20_measure_and_read(gpio_num_t pin, ds18x20_addr_t addr, float *t
 /**
  * @brief Perform a ds18x20_measure() followed by ds18x20_read_temp_multi()
  *
+ * Conversion is started on all devices on the bus. If any of them is
+ * parasite powered, the longest conversion time is waited, otherwise
+ * the conversion time of the slowest listed sensor.
+ *
  * @param pin         The GPIO pin connected to the ds18x20 bus
  * @param addr_list   A list of addresses for devices to read.
  * @param addr_count  The number of entries in `addr_list`.
@@ -224,6 +276,116 @@ esp_err_t ds18x20_measure_and_read(gpio_num_t pin, ds18x20_addr_t addr, float *t
  */
 esp_err_t ds18x20_measure_and_read_multi(gpio_num_t pin, ds18x20_addr_t *addr_list, size_t addr_count, float *result_list);
 
+/**
+ * @brief Measure temperature of multiple sensors in one acquisition cycle
+ *
+ * Starts conversion on all sensors on the bus with a single SKIP ROM
+ * command, sleeps while it is in progress and then reads scratchpads of
+ * sensors in `addr_list` one after another. Each scratchpad is read in
+ * a single bus transfer. \p callback is called for every sensor, all
+ * samples get timestamp of the conversion end.
+ *
+ * Sensors are read in groups by conversion time: results of
+ * low-resolution DS18B20 are read as soon as their conversion is done
+ * and the cycle lasts as long as conversion of the slowest listed sensor.
+ * Thus, acquisition of a list of 9-bit sensors is about 8 times faster
+ * than of 12-bit ones. If there are parasitically-powered devices on the
+ * bus, all sensors are read after the longest conversion time.
+ *
+ * @param pin         The GPIO pin connected to the ds18x20 bus
+ * @param addr_list   A list of addresses for devices to read.
+ * @param addr_count  The number of entries in `addr_list`.
+ * @param callback    Function to call for each sample
+ * @param ctx         Callback argument
+ *
+ * @returns `ESP_OK` if all temperatures were fetched successfully
+ */
+esp_err_t ds18x20_acquire(gpio_num_t pin, const ds18x20_addr_t *addr_list, size_t addr_count,
+        ds18x20_sample_cb_t callback, void *ctx);
+
+/**
+ * @brief Start periodic acquisition in background
+ *
+ * Creates a task which runs ::ds18x20_acquire() every `period_ms`
+ * milliseconds and passes samples to `queue` and/or `callback`.
+ * Fields `pin`, `addr_list`, `addr_count`, `period_ms`, `queue`,
+ * `callback` and `ctx` must be set before calling this function,
+ * other fields must be zeroed. `addr_list` must stay valid until
+ * acquisition is stopped.
+ *
+ * @param acq  Acquisition descriptor
+ * @returns `ESP_OK` on success
+ */
+esp_err_t ds18x20_acq_start(ds18x20_acq_t *acq);
+
+/**
+ * @brief Stop periodic acquisition
+ *
+ * Waits until the current acquisition cycle is finished and deletes
+ * the acquisition task. Must not be called from the sample callback,
+ * which runs in the acquisition task.
+ *
+ * @param acq  Acquisition descriptor
+ * @returns `ESP_OK` on success, `ESP_ERR_INVALID_STATE` if acquisition
+ *          is not running or function is called from the acquisition task
+ */
+esp_err_t ds18x20_acq_stop(ds18x20_acq_t *acq);
+
+/**
+ * @brief Get conversion time of the device
+ *
+ * Resolutions of DS18B20 devices are cached by the driver each time
+ * their scratchpad is read or written, so it is known after the first
+ * reading or after ::ds18b20_set_resolution(). Writing scratchpad with
+ * ::DS18X20_ANY updates cached devices of that bus only. Maximal time is
+ * returned for unknown devices and DS18S20.
+ *
+ * @param addr  The 64-bit address of the device
+ *
+ * @returns Conversion time, ms
+ */
+uint32_t ds18x20_conversion_time(ds18x20_addr_t addr);
+
+/**
+ * @brief Get DS18B20 resolution
+ *
+ * Scratchpad is read only if resolution of the device is not cached.
+ *
+ * @param pin         The GPIO pin connected to the ds18x20 device
+ * @param addr        The 64-bit address of the DS18B20 device
+ * @param[out] resolution Resolution
+ *
+ * @returns `ESP_OK` on success
+ */
+esp_err_t ds18b20_get_resolution(gpio_num_t pin, ds18x20_addr_t addr, ds18b20_resolution_t *resolution);
+
+/**
+ * @brief Set DS18B20 resolution
+ *
+ * Writes configuration register keeping alarm thresholds. New resolution
+ * is lost at power-off unless ::ds18x20_copy_scratchpad() is called.
+ *
+ * @param pin         The GPIO pin connected to the ds18x20 device
+ * @param addr        The 64-bit address of the DS18B20 device
+ * @param resolution  Resolution
+ *
+ * @returns `ESP_OK` on success
+ */
+esp_err_t ds18b20_set_resolution(gpio_num_t pin, ds18x20_addr_t addr, ds18b20_resolution_t resolution);
+
+/**
+ * @brief Check for parasitically-powered devices
+ *
+ * @param pin           The GPIO pin connected to the ds18x20 bus
+ * @param addr          The 64-bit address of the device. This can be set
+ *                      to ::DS18X20_ANY to check all devices on the bus.
+ * @param[out] parasite `true` if device (any device on the bus) is
+ *                      parasitically-powered
+ *
+ * @returns `ESP_OK` on success
+ */
+esp_err_t ds18x20_parasite_powered(gpio_num_t pin, ds18x20_addr_t addr, bool *parasite);
+
 /**
  * @brief Read the scratchpad data for a particular ds18x20 device.
  *
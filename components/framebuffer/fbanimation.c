@@ -30,6 +30,8 @@
  *
  * MIT Licensed as described in the file LICENSE
  */
+#include <string.h>
+#include <stdlib.h>
 #include <esp_err.h>
 #include <esp_log.h>
 #include "fbanimation.h"
@@ -39,62 +41,308 @@ static const char *TAG = "animation";
 #define CHECK(x) do { esp_err_t __; if ((__ = x) != ESP_OK) return __; } while (0)
 #define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
 
-static void display_frame(void *ctx)
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void account_draw(fb_animation_t *animation, uint32_t skipped, uint32_t time_us, esp_err_t res)
+{
+    portENTER_CRITICAL(&stats_lock);
+    fb_animation_stats_t *stats = &animation->stats;
+    stats->frames++;
+    stats->skipped += skipped;
+    stats->draw_us = time_us;
+    stats->draw_total_us += time_us;
+    if (time_us > stats->draw_max_us)
+        stats->draw_max_us = time_us;
+    if (res != ESP_OK)
+        stats->errors++;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+static void account_render(fb_animation_t *animation, uint32_t time_us, esp_err_t res)
+{
+    portENTER_CRITICAL(&stats_lock);
+    fb_animation_stats_t *stats = &animation->stats;
+    stats->render_us = time_us;
+    stats->render_total_us += time_us;
+    if (time_us > stats->render_max_us)
+        stats->render_max_us = time_us;
+    if (res == ESP_OK)
+        stats->rendered++;
+    else
+        stats->errors++;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+#if CONFIG_FB_ANIMATION_PIPELINE
+
+static bool hand_off(fb_animation_t *animation)
+{
+    framebuffer_t *fb = animation->fb;
+    framebuffer_t *frame = &animation->frame;
+
+    xSemaphoreTake(fb->mutex, portMAX_DELAY);
+    if (fb_is_dirty(fb))
+    {
+        // copy holds the previous frame, so only changed rows must be copied
+        memcpy(frame->data + FB_OFFSET(fb, 0, fb->dirty.y0), fb->data + FB_OFFSET(fb, 0, fb->dirty.y0),
+               (fb->dirty.y1 - fb->dirty.y0) * fb->width * sizeof(rgb_t));
+        // keep region of the frame which failed to render
+        if (!fb_is_dirty(frame))
+            frame->dirty = fb->dirty;
+        else
+        {
+            if (fb->dirty.x0 < frame->dirty.x0) frame->dirty.x0 = fb->dirty.x0;
+            if (fb->dirty.y0 < frame->dirty.y0) frame->dirty.y0 = fb->dirty.y0;
+            if (fb->dirty.x1 > frame->dirty.x1) frame->dirty.x1 = fb->dirty.x1;
+            if (fb->dirty.y1 > frame->dirty.y1) frame->dirty.y1 = fb->dirty.y1;
+        }
+        fb->dirty.x0 = fb->dirty.x1 = 0;
+    }
+    frame->frame_num = fb->frame_num;
+    frame->last_frame_us = fb->last_frame_us;
+    xSemaphoreGive(fb->mutex);
+
+    // nothing changed since last rendered frame
+    return fb_is_dirty(frame);
+}
+
+static void render_task(void *ctx)
 {
     fb_animation_t *animation = (fb_animation_t *)ctx;
+    framebuffer_t *frame = &animation->frame;
+
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        int64_t start = esp_timer_get_time();
+        esp_err_t res = frame->render(frame, animation->render_ctx);
+        if (res == ESP_OK)
+            frame->dirty.x0 = frame->dirty.x1 = 0;
+        else
+            ESP_LOGE(TAG, "Error rendering frame %d (%s)", res, esp_err_to_name(res));
+        account_render(animation, esp_timer_get_time() - start, res);
+
+        xSemaphoreGive(animation->idle);
+    }
+}
 
+#endif
+
+static void draw_frame(fb_animation_t *animation, uint32_t ticks)
+{
     // run effect
-    esp_err_t res = animation->draw ? animation->draw(animation->fb) : ESP_FAIL;
+    int64_t start = esp_timer_get_time();
+    esp_err_t res = animation->draw(animation->fb);
+    account_draw(animation, ticks - 1, esp_timer_get_time() - start, res);
     if (res != ESP_OK)
     {
         ESP_LOGE(TAG, "Error running effect %d (%s)", res, esp_err_to_name(res));
         return;
     }
+
+#if CONFIG_FB_ANIMATION_PIPELINE
+    // pass frame to render task
+    if (xSemaphoreTake(animation->idle, 0) != pdTRUE)
+    {
+        portENTER_CRITICAL(&stats_lock);
+        animation->stats.dropped++;
+        portEXIT_CRITICAL(&stats_lock);
+        return;
+    }
+    if (!hand_off(animation))
+    {
+        xSemaphoreGive(animation->idle);
+        return;
+    }
+    xTaskNotifyGive(animation->render_task);
+#else
     // render frame
+    start = esp_timer_get_time();
     res = fb_render(animation->fb, animation->render_ctx);
     if (res != ESP_OK)
-    {
         ESP_LOGE(TAG, "Error rendering frame %d (%s)", res, esp_err_to_name(res));
-        return;
+    account_render(animation, esp_timer_get_time() - start, res);
+#endif
+}
+
+static void draw_task(void *ctx)
+{
+    fb_animation_t *animation = (fb_animation_t *)ctx;
+
+    while (1)
+    {
+        // number of timer ticks since last frame, all but one are skipped
+        uint32_t ticks = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        xSemaphoreTake(animation->lock, portMAX_DELAY);
+        if (animation->draw)
+            draw_frame(animation, ticks);
+        xSemaphoreGive(animation->lock);
     }
 }
 
+static void timer_tick(void *ctx)
+{
+    xTaskNotifyGive(((fb_animation_t *)ctx)->draw_task);
+}
+
+static void release(fb_animation_t *animation)
+{
+    if (animation->timer)
+    {
+        esp_timer_stop(animation->timer);
+        esp_timer_delete(animation->timer);
+        animation->timer = NULL;
+    }
+    if (animation->draw_task)
+    {
+        vTaskDelete(animation->draw_task);
+        animation->draw_task = NULL;
+    }
+    if (animation->lock)
+    {
+        vSemaphoreDelete(animation->lock);
+        animation->lock = NULL;
+    }
+#if CONFIG_FB_ANIMATION_PIPELINE
+    if (animation->render_task)
+    {
+        vTaskDelete(animation->render_task);
+        animation->render_task = NULL;
+    }
+    if (animation->idle)
+    {
+        vSemaphoreDelete(animation->idle);
+        animation->idle = NULL;
+    }
+    if (animation->frame.data)
+    {
+        free(animation->frame.data);
+        animation->frame.data = NULL;
+    }
+#endif
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 esp_err_t fb_animation_init(fb_animation_t *animation, framebuffer_t *fb)
 {
-    CHECK_ARG(animation && fb);
+    CHECK_ARG(animation && fb && fb->data);
 
+    memset(animation, 0, sizeof(fb_animation_t));
     animation->fb = fb;
-    animation->timer = NULL;
+
+    animation->lock = xSemaphoreCreateMutex();
+    if (!animation->lock)
+        goto no_mem;
+
+#if CONFIG_FB_ANIMATION_PIPELINE
+    framebuffer_t *frame = &animation->frame;
+    frame->width = fb->width;
+    frame->height = fb->height;
+    frame->render = fb->render;
+    frame->data = malloc(FB_SIZE(fb));
+    if (!frame->data)
+        goto no_mem;
+    memcpy(frame->data, fb->data, FB_SIZE(fb));
+    frame->dirty.x1 = fb->width;
+    frame->dirty.y1 = fb->height;
+
+    animation->idle = xSemaphoreCreateBinary();
+    if (!animation->idle)
+        goto no_mem;
+    xSemaphoreGive(animation->idle);
+
+    if (xTaskCreate(render_task, "fb_render", CONFIG_FB_ANIMATION_TASK_STACK_SIZE, animation,
+            CONFIG_FB_ANIMATION_TASK_PRIORITY, &animation->render_task) != pdPASS)
+        goto no_mem;
+#endif
+
+    if (xTaskCreate(draw_task, "fb_draw", CONFIG_FB_ANIMATION_TASK_STACK_SIZE, animation,
+            CONFIG_FB_ANIMATION_TASK_PRIORITY, &animation->draw_task) != pdPASS)
+        goto no_mem;
+
     esp_timer_create_args_t timer_args = {
         .arg = animation,
-        .callback = display_frame,
+        .callback = timer_tick,
         .dispatch_method = ESP_TIMER_TASK,
     };
-    return esp_timer_create(&timer_args, &animation->timer);
+    esp_err_t res = esp_timer_create(&timer_args, &animation->timer);
+    if (res != ESP_OK)
+    {
+        release(animation);
+        return res;
+    }
+
+    return ESP_OK;
+
+no_mem:
+    ESP_LOGE(TAG, "Could not allocate animation resources");
+    release(animation);
+    return ESP_ERR_NO_MEM;
 }
 
 esp_err_t fb_animation_play(fb_animation_t *animation, uint8_t fps, fb_draw_cb_t draw, void *render_ctx)
 {
-    CHECK_ARG(animation && fps && draw);
+    CHECK_ARG(animation && animation->timer && fps && draw);
 
+    xSemaphoreTake(animation->lock, portMAX_DELAY);
     animation->render_ctx = render_ctx;
     animation->draw = draw;
+    xSemaphoreGive(animation->lock);
+
     return esp_timer_start_periodic(animation->timer, 1000000 / fps);
 }
 
 esp_err_t fb_animation_stop(fb_animation_t *animation)
+{
+    CHECK_ARG(animation && animation->timer);
+
+    esp_err_t res = esp_timer_stop(animation->timer);
+
+    // wait for frame being drawn
+    xSemaphoreTake(animation->lock, portMAX_DELAY);
+    animation->draw = NULL;
+    xSemaphoreGive(animation->lock);
+
+#if CONFIG_FB_ANIMATION_PIPELINE
+    // wait for frame being rendered
+    xSemaphoreTake(animation->idle, portMAX_DELAY);
+    xSemaphoreGive(animation->idle);
+#endif
+
+    return res;
+}
+
+esp_err_t fb_animation_get_stats(fb_animation_t *animation, fb_animation_stats_t *stats)
+{
+    CHECK_ARG(animation && stats);
+
+    portENTER_CRITICAL(&stats_lock);
+    *stats = animation->stats;
+    portEXIT_CRITICAL(&stats_lock);
+
+    return ESP_OK;
+}
+
+esp_err_t fb_animation_reset_stats(fb_animation_t *animation)
 {
     CHECK_ARG(animation);
 
-    return esp_timer_stop(animation->timer);
+    portENTER_CRITICAL(&stats_lock);
+    memset(&animation->stats, 0, sizeof(fb_animation_stats_t));
+    portEXIT_CRITICAL(&stats_lock);
+
+    return ESP_OK;
 }
 
 esp_err_t fb_animation_free(fb_animation_t *animation)
 {
-    CHECK_ARG(animation);
+    CHECK_ARG(animation && animation->timer);
+
+    fb_animation_stop(animation);
+    release(animation);
 
-    esp_timer_stop(animation->timer);
-    return esp_timer_delete(animation->timer);
+    return ESP_OK;
 }
@@ -36,6 +36,9 @@
 #define __FBANIMATION_H__
 
 #include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
 #include "framebuffer.h"
 
 #ifdef __cplusplus
@@ -47,6 +50,24 @@ extern "C" {
  */
 typedef esp_err_t (*fb_draw_cb_t)(framebuffer_t *fb);
 
+/**
+ * Animation statistics
+ */
+typedef struct
+{
+    uint32_t frames;           ///< Number of drawn frames
+    uint32_t rendered;         ///< Number of rendered frames
+    uint32_t skipped;          ///< Number of frame periods skipped because previous frame was late
+    uint32_t dropped;          ///< Number of drawn frames not rendered because renderer was busy
+    uint32_t errors;           ///< Number of draw and render errors
+    uint32_t draw_us;          ///< Last frame draw time, us
+    uint32_t draw_max_us;      ///< Longest frame draw time, us
+    uint64_t draw_total_us;    ///< Total frame draw time, us
+    uint32_t render_us;        ///< Last frame render time, us
+    uint32_t render_max_us;    ///< Longest frame render time, us
+    uint64_t render_total_us;  ///< Total frame render time, us
+} fb_animation_stats_t;
+
 /**
  * Animation descriptor
  */
@@ -56,6 +77,14 @@ typedef struct
     void *render_ctx;          ///< Renderer context
     esp_timer_handle_t timer;  ///< Animation timer
     fb_draw_cb_t draw;         ///< Draw function
+    TaskHandle_t draw_task;    ///< Task drawing frames
+    SemaphoreHandle_t lock;    ///< Held by draw task while frame is drawn
+    fb_animation_stats_t stats; ///< Statistics, use ::fb_animation_get_stats() to read
+#if CONFIG_FB_ANIMATION_PIPELINE || defined(__DOXYGEN__)
+    TaskHandle_t render_task;  ///< Task rendering frames
+    SemaphoreHandle_t idle;    ///< Given by render task when it is ready for next frame
+    framebuffer_t frame;       ///< Copy of the drawn frame passed to renderer
+#endif
 } fb_animation_t;
 
 /**
@@ -70,6 +99,27 @@ esp_err_t fb_animation_init(fb_animation_t *animation, framebuffer_t *fb);
 /**
  * @brief Play animation
  *
+ * Timer ticks at \p fps and wakes up draw task. Ticks are scheduled
+ * on absolute time, so frame rate does not drift. When drawing and
+ * rendering of a frame take longer than the frame period, missed ticks
+ * are not replayed: next frame is drawn once and missed periods are
+ * counted as skipped.
+ *
+ * When option CONFIG_FB_ANIMATION_PIPELINE is enabled, drawn frame is
+ * copied to a second buffer and rendered by a separate task while the
+ * next frame is drawn. If renderer is still busy with previous frame,
+ * the new one is not rendered and counted as dropped; its changes are
+ * rendered with the next frame. Only rows marked dirty are copied and
+ * a frame without changes is not rendered, so effects writing
+ * `fb->data` directly must call ::fb_mark_dirty().
+ *
+ * Renderer callback gets a framebuffer descriptor of the copy instead
+ * of the user framebuffer. This descriptor has no mutex, and its
+ * render callback is the one the framebuffer had at ::fb_animation_init(),
+ * later changes of `fb->render` are ignored. Renderer must use only
+ * `width`, `height`, `data`, `dirty` and frame counters of the
+ * descriptor it gets.
+ *
  * @param animation     Animation descriptor
  * @param fps           Target FPS
  * @param draw          Function for drawing on a framebuffer
@@ -81,11 +131,31 @@ esp_err_t fb_animation_play(fb_animation_t *animation, uint8_t fps, fb_draw_cb_t
 /**
  * @brief Stop playing animation
  *
+ * Waits until the frame being drawn and rendered is finished,
+ * so effect can be safely freed after this call.
+ *
  * @param animation     Animation descriptor
  * @return              ESP_OK on success
  */
 esp_err_t fb_animation_stop(fb_animation_t *animation);
 
+/**
+ * @brief Get animation statistics
+ *
+ * @param animation     Animation descriptor
+ * @param[out] stats    Snapshot of animation statistics
+ * @return              ESP_OK on success
+ */
+esp_err_t fb_animation_get_stats(fb_animation_t *animation, fb_animation_stats_t *stats);
+
+/**
+ * @brief Reset animation statistics
+ *
+ * @param animation     Animation descriptor
+ * @return              ESP_OK on success
+ */
+esp_err_t fb_animation_reset_stats(fb_animation_t *animation);
+
 /**
  * @brief Create animation based on LED effect
  *
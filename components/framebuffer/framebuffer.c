@@ -36,10 +36,31 @@
 #define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
 #define CHECK(x) do { esp_err_t __; if ((__ = (x)) != ESP_OK) return __; } while (0)
 
-static size_t xy(void *ctx, size_t x, size_t y)
+static inline void mark_dirty(framebuffer_t *fb, size_t x0, size_t y0, size_t x1, size_t y1)
 {
-    framebuffer_t *fb = (framebuffer_t *)ctx;
-    return y * fb->width + x;
+    if (fb->dirty.x0 >= fb->dirty.x1)
+    {
+        fb->dirty = (fb_rect_t){ x0, y0, x1, y1 };
+        return;
+    }
+    if (x0 < fb->dirty.x0) fb->dirty.x0 = x0;
+    if (y0 < fb->dirty.y0) fb->dirty.y0 = y0;
+    if (x1 > fb->dirty.x1) fb->dirty.x1 = x1;
+    if (y1 > fb->dirty.y1) fb->dirty.y1 = y1;
+}
+
+static inline void mark_all_dirty(framebuffer_t *fb)
+{
+    fb->dirty = (fb_rect_t){ 0, 0, fb->width, fb->height };
+}
+
+static inline void set_pixel(framebuffer_t *fb, size_t x, size_t y, rgb_t color)
+{
+    rgb_t *p = fb->data + FB_OFFSET(fb, x, y);
+    if (rgb_is_equal(*p, color))
+        return;
+    *p = color;
+    mark_dirty(fb, x, y, x + 1, y + 1);
 }
 
 esp_err_t fb_init(framebuffer_t *fb, size_t width, size_t height, fb_render_cb_t render_cb)
@@ -52,6 +73,7 @@ esp_err_t fb_init(framebuffer_t *fb, size_t width, size_t height, fb_render_cb_t
     fb->last_frame_us = 0;
     fb->render = render_cb;
     fb->internal = NULL;
+    mark_all_dirty(fb);
     fb->mutex = xSemaphoreCreateMutex();
     if (!fb->mutex)
         return ESP_ERR_NO_MEM;
@@ -80,17 +102,19 @@ esp_err_t fb_render(framebuffer_t *fb, void *render_ctx)
 
     if (xSemaphoreTake(fb->mutex, 0) != pdTRUE)
         return ESP_ERR_INVALID_STATE;
-    CHECK(fb->render(fb, render_ctx));
+    esp_err_t res = fb->render(fb, render_ctx);
+    if (res == ESP_OK)
+        fb->dirty.x0 = fb->dirty.x1 = 0;
     xSemaphoreGive(fb->mutex);
 
-    return ESP_OK;
+    return res;
 }
 
 esp_err_t fb_set_pixel_rgb(framebuffer_t *fb, size_t x, size_t y, rgb_t color)
 {
     CHECK_ARG(fb && fb->data && x < fb->width && y < fb->height);
 
-    fb->data[FB_OFFSET(fb, x, y)] = color;
+    set_pixel(fb, x, y, color);
 
     return ESP_OK;
 }
@@ -99,7 +123,7 @@ esp_err_t fb_set_pixel_hsv(framebuffer_t *fb, size_t x, size_t y, hsv_t color)
 {
     CHECK_ARG(fb && fb->data && x < fb->width && y < fb->height);
 
-    fb->data[FB_OFFSET(fb, x, y)] = hsv2rgb_rainbow(color);
+    set_pixel(fb, x, y, hsv2rgb_rainbow(color));
 
     return ESP_OK;
 }
@@ -167,6 +191,7 @@ esp_err_t fb_clear(framebuffer_t *fb)
     CHECK_ARG(fb && fb->data);
 
     memset(fb->data, 0, FB_SIZE(fb));
+    mark_all_dirty(fb);
 
     return ESP_OK;
 }
@@ -204,6 +229,7 @@ esp_err_t fb_shift(framebuffer_t *fb, size_t offs, fb_shift_direction_t dir)
                     FB_SIZE(fb) - offs * fb->width * sizeof(rgb_t));
             break;
     }
+    mark_all_dirty(fb);
 
     return ESP_OK;
 }
@@ -212,8 +238,24 @@ esp_err_t fb_fade(framebuffer_t *fb, uint8_t scale)
 {
     CHECK_ARG(fb && fb->data);
 
-    for (size_t i = 0; i < fb->width * fb->height; i++)
-        fb->data[i] = rgb_fade(fb->data[i], scale);
+    if (!scale)
+        return ESP_OK;
+
+    // any non-zero channel is changed by non-zero fade and black pixels stay
+    // black, so only the lit span of each row is faded and marked dirty
+    rgb_t *row = fb->data;
+    for (size_t y = 0; y < fb->height; y++, row += fb->width)
+    {
+        size_t x0 = 0, x1 = fb->width;
+        while (x0 < x1 && rgb_is_zero(row[x0]))
+            x0++;
+        while (x1 > x0 && rgb_is_zero(row[x1 - 1]))
+            x1--;
+        if (x0 == x1)
+            continue;
+        rgb_array_fade(row + x0, x1 - x0, scale);
+        mark_dirty(fb, x0, y, x1, y + 1);
+    }
 
     return ESP_OK;
 }
@@ -222,7 +264,8 @@ esp_err_t fb_blur2d(framebuffer_t *fb, fract8 amount)
 {
     CHECK_ARG(fb && fb->data);
 
-    blur2d(fb->data, fb->width, fb->height, amount, xy, fb);
+    blur2d(fb->data, fb->width, fb->height, amount, NULL, NULL);
+    mark_all_dirty(fb);
 
     return ESP_OK;
 }
@@ -247,3 +290,28 @@ esp_err_t fb_end(framebuffer_t *fb)
 
     return ESP_OK;
 }
+
+bool fb_is_dirty(const framebuffer_t *fb)
+{
+    return fb && fb->dirty.x0 < fb->dirty.x1 && fb->dirty.y0 < fb->dirty.y1;
+}
+
+esp_err_t fb_mark_dirty(framebuffer_t *fb, size_t x, size_t y, size_t w, size_t h)
+{
+    CHECK_ARG(fb);
+
+    if (x >= fb->width || y >= fb->height || !w || !h)
+        return ESP_OK;
+    mark_dirty(fb, x, y, w > fb->width - x ? fb->width : x + w, h > fb->height - y ? fb->height : y + h);
+
+    return ESP_OK;
+}
+
+esp_err_t fb_clear_dirty(framebuffer_t *fb)
+{
+    CHECK_ARG(fb);
+
+    fb->dirty.x0 = fb->dirty.x1 = 0;
+
+    return ESP_OK;
+}
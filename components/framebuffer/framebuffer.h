@@ -55,6 +55,17 @@ typedef enum {
     FB_SHIFT_DOWN
 } fb_shift_direction_t;
 
+/**
+ * Rectangular framebuffer region
+ */
+typedef struct
+{
+    size_t x0;                     ///< Left column, inclusive
+    size_t y0;                     ///< Top row, inclusive
+    size_t x1;                     ///< Right column, exclusive
+    size_t y1;                     ///< Bottom row, exclusive
+} fb_rect_t;
+
 typedef struct framebuffer_s framebuffer_t;
 
 /**
@@ -75,6 +86,7 @@ struct framebuffer_s
     fb_render_cb_t render;         ///< See ::fb_render()
     uint8_t *internal;             ///< Buffer for effect settings, internal vars, palettes and so on
     SemaphoreHandle_t mutex;
+    fb_rect_t dirty;               ///< Bounding box of pixels changed since last ::fb_render(), empty if `x0 >= x1`
 };
 
 /**
@@ -241,6 +253,42 @@ esp_err_t fb_begin(framebuffer_t *fb);
  */
 esp_err_t fb_end(framebuffer_t *fb);
 
+/**
+ * @brief Check if any pixel changed since last render
+ *
+ * Changes are tracked by framebuffer functions only. Code writing
+ * `fb->data` directly must call ::fb_mark_dirty().
+ *
+ * @param fb     Framebuffer descriptor
+ * @return       true if framebuffer has changed pixels
+ */
+bool fb_is_dirty(const framebuffer_t *fb);
+
+/**
+ * @brief Add region to the changed pixels bounding box
+ *
+ * Region is clipped to the framebuffer size.
+ *
+ * @param fb     Framebuffer descriptor
+ * @param x      Left column
+ * @param y      Top row
+ * @param w      Region width
+ * @param h      Region height
+ * @return       ESP_OK on success
+ */
+esp_err_t fb_mark_dirty(framebuffer_t *fb, size_t x, size_t y, size_t w, size_t h);
+
+/**
+ * @brief Forget changed pixels
+ *
+ * Called by ::fb_render() after successful rendering, so the render
+ * callback can read `fb->dirty` to update only the changed region.
+ *
+ * @param fb     Framebuffer descriptor
+ * @return       ESP_OK on success
+ */
+esp_err_t fb_clear_dirty(framebuffer_t *fb);
+
 #ifdef __cplusplus
 }
 #endif
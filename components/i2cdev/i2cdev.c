@@ -34,24 +34,150 @@
 #include <inttypes.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <freertos/queue.h>
 #include <esp_log.h>
+#if CONFIG_I2CDEV_STATS
+#include <esp_timer.h>
+#endif
 #include "i2cdev.h"
 
 static const char *TAG = "i2cdev";
 
+#if CONFIG_I2CDEV_STATS
+// Device statistics are kept in port state, so device descriptors can be
+// const. Devices are identified by address and I2C switch channel.
+typedef struct {
+    bool used;
+    uint8_t addr;
+    uint8_t mux_addr;
+    uint8_t mux_channel;
+    i2c_dev_stats_t stats;
+} dev_stats_t;
+#endif
+
+#if CONFIG_I2CDEV_FAST_CLOCK_SWITCH
+// Number of clock speeds with cached timing per port
+#define TIMING_CACHE_SIZE 4
+
+// SCL timing calculated by the driver for a clock speed
+typedef struct {
+    uint32_t clk_speed; // 0 if entry is free
+    int high_period;
+    int low_period;
+    int start_setup;
+    int start_hold;
+    int stop_setup;
+    int stop_hold;
+    int sample_time;
+    int hold_time;
+} timing_t;
+#endif
+
 typedef struct {
     SemaphoreHandle_t lock;
     i2c_config_t config;
     bool installed;
+    QueueHandle_t queue;
+    TaskHandle_t worker;
+    uint8_t mux_known;       // bit N is set when channels of switch at MUX_ADDR_FIRST + N are known
+    uint8_t mux_channels[8]; // cached channels of I2C switches
+#if CONFIG_I2CDEV_FAST_CLOCK_SWITCH
+    timing_t timing[TIMING_CACHE_SIZE]; // cached timing of clock speeds used on port
+    size_t timing_next;                 // entry to replace next
+#endif
+#if CONFIG_I2CDEV_STATS
+    i2c_port_stats_t stats;
+    dev_stats_t devs[CONFIG_I2CDEV_STATS_DEVICES];
+#endif
 } i2c_port_state_t;
 
 static i2c_port_state_t states[I2C_NUM_MAX];
 
+static esp_err_t async_stop(i2c_port_t port);
+
+#if CONFIG_I2CDEV_STATS
+
+static void stats_add(i2c_dev_stats_t *stats, esp_err_t res, size_t bytes, uint32_t us)
+{
+    stats->transactions++;
+    stats->bytes += bytes;
+    if (res == ESP_FAIL)
+        stats->nacks++;
+    else if (res == ESP_ERR_TIMEOUT)
+        stats->timeouts++;
+    else if (res != ESP_OK)
+        stats->errors++;
+
+    stats->busy_us += us;
+    if (us > stats->max_us)
+        stats->max_us = us;
+    size_t bucket = 0;
+    while (bucket < I2CDEV_STATS_HIST_SIZE - 1 && us >= (64U << bucket))
+        bucket++;
+    stats->hist[bucket]++;
+}
+
+// Must be called with port locked. Returns NULL if device has no statistics
+// and either add is false or there is no free entry.
+static dev_stats_t *dev_stats(const i2c_dev_t *dev, bool add)
+{
+    dev_stats_t *free_entry = NULL;
+    for (size_t i = 0; i < CONFIG_I2CDEV_STATS_DEVICES; i++)
+    {
+        dev_stats_t *e = &states[dev->port].devs[i];
+        if (!e->used)
+        {
+            if (!free_entry)
+                free_entry = e;
+        }
+        else if (e->addr == dev->addr && e->mux_addr == dev->mux_addr && e->mux_channel == dev->mux_channel)
+            return e;
+    }
+    if (!add || !free_entry)
+        return NULL;
+
+    memset(free_entry, 0, sizeof(dev_stats_t));
+    free_entry->used = true;
+    free_entry->addr = dev->addr;
+    free_entry->mux_addr = dev->mux_addr;
+    free_entry->mux_channel = dev->mux_channel;
+    return free_entry;
+}
+
+static void dev_stats_add(const i2c_dev_t *dev, esp_err_t res, size_t bytes, uint32_t us)
+{
+    dev_stats_t *e = dev_stats(dev, true);
+    if (e)
+        stats_add(&e->stats, res, bytes, us);
+}
+
+static bool port_take(i2c_port_t port)
+{
+    int64_t start = esp_timer_get_time();
+    if (!xSemaphoreTake(states[port].lock, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT)))
+    {
+        states[port].stats.lock_timeouts++;
+        return false;
+    }
+    uint32_t us = esp_timer_get_time() - start;
+    states[port].stats.lock_waits++;
+    states[port].stats.lock_wait_us += us;
+    if (us > states[port].stats.lock_wait_max_us)
+        states[port].stats.lock_wait_max_us = us;
+    return true;
+}
+
+#else
+
+#define port_take(port) xSemaphoreTake(states[port].lock, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT))
+
+#endif
+
 #if CONFIG_I2CDEV_NOLOCK
 #define SEMAPHORE_TAKE(port)
 #else
 #define SEMAPHORE_TAKE(port) do { \
-        if (!xSemaphoreTake(states[port].lock, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT))) \
+        if (!port_take(port)) \
         { \
             ESP_LOGE(TAG, "Could not take port mutex %d", port); \
             return ESP_ERR_TIMEOUT; \
@@ -96,11 +222,21 @@ esp_err_t i2cdev_done()
     {
         if (!states[i].lock) continue;
 
+        // worker needs the port lock to execute pending transfers
+        if (states[i].worker)
+        {
+            esp_err_t res = async_stop(i);
+            if (res != ESP_OK)
+                return res;
+        }
         if (states[i].installed)
         {
             SEMAPHORE_TAKE(i);
-            i2c_driver_delete(i);
-            states[i].installed = false;
+            if (states[i].installed)
+            {
+                i2c_driver_delete(i);
+                states[i].installed = false;
+            }
             SEMAPHORE_GIVE(i);
         }
 #if !CONFIG_I2CDEV_NOLOCK
@@ -173,24 +309,99 @@ esp_err_t i2c_dev_give_mutex(i2c_dev_t *dev)
     return ESP_OK;
 }
 
-inline static bool cfg_equal(const i2c_config_t *a, const i2c_config_t *b)
+inline static bool cfg_equal_pins(const i2c_config_t *a, const i2c_config_t *b)
 {
     return a->scl_io_num == b->scl_io_num
         && a->sda_io_num == b->sda_io_num
+        && a->scl_pullup_en == b->scl_pullup_en
+        && a->sda_pullup_en == b->sda_pullup_en;
+}
+
+inline static bool cfg_equal(const i2c_config_t *a, const i2c_config_t *b)
+{
+    return cfg_equal_pins(a, b)
 #if HELPER_TARGET_IS_ESP32
         && a->master.clk_speed == b->master.clk_speed
 #elif HELPER_TARGET_IS_ESP8266
         && a->clk_stretch_tick == b->clk_stretch_tick
 #endif
-        && a->scl_pullup_en == b->scl_pullup_en
-        && a->sda_pullup_en == b->sda_pullup_en;
+        ;
+}
+
+#if CONFIG_I2CDEV_FAST_CLOCK_SWITCH
+
+// Below this frequency the driver may select another source clock divider,
+// which is not restored by the timing registers
+#define FAST_CLOCK_SWITCH_MIN_HZ 50000
+
+static esp_err_t i2c_switch_clock(const i2c_dev_t *dev)
+{
+    i2c_port_state_t *state = &states[dev->port];
+    uint32_t clk_speed = dev->cfg.master.clk_speed;
+    esp_err_t res;
+
+    timing_t *t = NULL;
+    for (size_t i = 0; i < TIMING_CACHE_SIZE && !t; i++)
+        if (state->timing[i].clk_speed == clk_speed)
+            t = &state->timing[i];
+
+    if (t
+        && clk_speed >= FAST_CLOCK_SWITCH_MIN_HZ
+        && states[dev->port].config.master.clk_speed >= FAST_CLOCK_SWITCH_MIN_HZ)
+    {
+        ESP_LOGV(TAG, "Restoring cached timing for %" PRIu32 " Hz on port %d", clk_speed, dev->port);
+        if ((res = i2c_set_period(dev->port, t->high_period, t->low_period)) != ESP_OK
+            || (res = i2c_set_start_timing(dev->port, t->start_setup, t->start_hold)) != ESP_OK
+            || (res = i2c_set_stop_timing(dev->port, t->stop_setup, t->stop_hold)) != ESP_OK
+            || (res = i2c_set_data_timing(dev->port, t->sample_time, t->hold_time)) != ESP_OK)
+            return res;
+    }
+    else
+    {
+        // Let the driver calculate timing without reinstallation and remember it
+        ESP_LOGD(TAG, "Calculating timing for %" PRIu32 " Hz on port %d", clk_speed, dev->port);
+        i2c_config_t temp;
+        memcpy(&temp, &dev->cfg, sizeof(i2c_config_t));
+        temp.mode = I2C_MODE_MASTER;
+        if ((res = i2c_param_config(dev->port, &temp)) != ESP_OK)
+            return res;
+
+        if (!t)
+        {
+            t = &state->timing[state->timing_next];
+            state->timing_next = (state->timing_next + 1) % TIMING_CACHE_SIZE;
+        }
+        t->clk_speed = 0;
+        if ((res = i2c_get_period(dev->port, &t->high_period, &t->low_period)) != ESP_OK
+            || (res = i2c_get_start_timing(dev->port, &t->start_setup, &t->start_hold)) != ESP_OK
+            || (res = i2c_get_stop_timing(dev->port, &t->stop_setup, &t->stop_hold)) != ESP_OK
+            || (res = i2c_get_data_timing(dev->port, &t->sample_time, &t->hold_time)) != ESP_OK)
+            return res;
+        t->clk_speed = clk_speed;
+    }
+
+    states[dev->port].config.master.clk_speed = clk_speed;
+#if CONFIG_I2CDEV_STATS
+    states[dev->port].stats.clock_switches++;
+#endif
+
+    return ESP_OK;
 }
 
+#endif
+
 static esp_err_t i2c_setup_port(const i2c_dev_t *dev)
 {
     if (dev->port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
 
     esp_err_t res;
+#if CONFIG_I2CDEV_FAST_CLOCK_SWITCH
+    if (states[dev->port].installed
+        && dev->cfg.master.clk_speed != states[dev->port].config.master.clk_speed
+        && cfg_equal_pins(&dev->cfg, &states[dev->port].config)
+        && (res = i2c_switch_clock(dev)) != ESP_OK)
+        return res;
+#endif
     if (!cfg_equal(&dev->cfg, &states[dev->port].config) || !states[dev->port].installed)
     {
         ESP_LOGD(TAG, "Reconfiguring I2C driver on port %d", dev->port);
@@ -203,6 +414,9 @@ static esp_err_t i2c_setup_port(const i2c_dev_t *dev)
         {
             i2c_driver_delete(dev->port);
             states[dev->port].installed = false;
+#if CONFIG_I2CDEV_STATS
+            states[dev->port].stats.reinstalls++;
+#endif
         }
 #if HELPER_TARGET_IS_ESP32
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
@@ -245,13 +459,97 @@ static esp_err_t i2c_setup_port(const i2c_dev_t *dev)
     return ESP_OK;
 }
 
+static esp_err_t cmd_begin(i2c_port_t port, const i2c_dev_t *dev, i2c_cmd_handle_t cmd, size_t bytes)
+{
+#if CONFIG_I2CDEV_STATS
+    int64_t start = esp_timer_get_time();
+#endif
+    esp_err_t res = i2c_master_cmd_begin(port, cmd, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT));
+#if CONFIG_I2CDEV_STATS
+    uint32_t us = esp_timer_get_time() - start;
+    stats_add(&states[port].stats.xfer, res, bytes, us);
+    if (dev)
+        dev_stats_add(dev, res, bytes, us);
+#endif
+    return res;
+}
+
+// Address range of TCA9548-compatible I2C switches
+#define MUX_ADDR_FIRST 0x70
+#define MUX_ADDR_LAST  0x77
+
+inline static bool mux_valid(uint8_t mux_addr, uint8_t channel)
+{
+    return mux_addr >= MUX_ADDR_FIRST && mux_addr <= MUX_ADDR_LAST && channel < 8;
+}
+
+static esp_err_t mux_write(i2c_port_t port, uint8_t mux_addr, uint8_t channels)
+{
+    size_t idx = mux_addr - MUX_ADDR_FIRST;
+
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, mux_addr << 1, true);
+    i2c_master_write_byte(cmd, channels, true);
+    i2c_master_stop(cmd);
+    esp_err_t res = cmd_begin(port, NULL, cmd, 1);
+    i2c_cmd_link_delete(cmd);
+
+    if (res != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Could not switch channels of I2C switch [0x%02x at %d]: %d (%s)", mux_addr, port, res, esp_err_to_name(res));
+        states[port].mux_known &= ~(1 << idx);
+        return res;
+    }
+
+    states[port].mux_channels[idx] = channels;
+    states[port].mux_known |= 1 << idx;
+#if CONFIG_I2CDEV_STATS
+    states[port].stats.mux_switches++;
+#endif
+    return ESP_OK;
+}
+
+inline static bool mux_pending(const i2c_dev_t *dev)
+{
+    if (!dev->mux_addr) return false;
+    if (!mux_valid(dev->mux_addr, dev->mux_channel)) return true;
+
+    size_t idx = dev->mux_addr - MUX_ADDR_FIRST;
+    return !(states[dev->port].mux_known & (1 << idx))
+        || states[dev->port].mux_channels[idx] != (1 << dev->mux_channel);
+}
+
+static esp_err_t mux_select(const i2c_dev_t *dev)
+{
+    if (!mux_pending(dev)) return ESP_OK;
+    if (!mux_valid(dev->mux_addr, dev->mux_channel)) return ESP_ERR_INVALID_ARG;
+
+    // Disconnect channels of other known switches to avoid address conflicts
+    esp_err_t res;
+    for (size_t i = 0; i <= MUX_ADDR_LAST - MUX_ADDR_FIRST; i++)
+        if (MUX_ADDR_FIRST + i != dev->mux_addr
+            && (states[dev->port].mux_known & (1 << i))
+            && states[dev->port].mux_channels[i]
+            && (res = mux_write(dev->port, MUX_ADDR_FIRST + i, 0)) != ESP_OK)
+            return res;
+
+    return mux_write(dev->port, dev->mux_addr, 1 << dev->mux_channel);
+}
+
+static esp_err_t setup_dev(const i2c_dev_t *dev)
+{
+    esp_err_t res = i2c_setup_port(dev);
+    return res == ESP_OK ? mux_select(dev) : res;
+}
+
 esp_err_t i2c_dev_probe(const i2c_dev_t *dev, i2c_dev_type_t operation_type)
 {
     if (!dev) return ESP_ERR_INVALID_ARG;
 
     SEMAPHORE_TAKE(dev->port);
 
-    esp_err_t res = i2c_setup_port(dev);
+    esp_err_t res = setup_dev(dev);
     if (res == ESP_OK)
     {
         i2c_cmd_handle_t cmd = i2c_cmd_link_create();
@@ -259,7 +557,7 @@ esp_err_t i2c_dev_probe(const i2c_dev_t *dev, i2c_dev_type_t operation_type)
         i2c_master_write_byte(cmd, dev->addr << 1 | (operation_type == I2C_DEV_READ ? 1 : 0), true);
         i2c_master_stop(cmd);
 
-        res = i2c_master_cmd_begin(dev->port, cmd, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT));
+        res = cmd_begin(dev->port, dev, cmd, 0);
 
         i2c_cmd_link_delete(cmd);
     }
@@ -269,28 +567,44 @@ esp_err_t i2c_dev_probe(const i2c_dev_t *dev, i2c_dev_type_t operation_type)
     return res;
 }
 
+static void cmd_add_read(i2c_cmd_handle_t cmd, const i2c_dev_t *dev, const void *out_data, size_t out_size,
+        void *in_data, size_t in_size)
+{
+    if (out_data && out_size)
+    {
+        i2c_master_start(cmd);
+        i2c_master_write_byte(cmd, dev->addr << 1, true);
+        i2c_master_write(cmd, (void *)out_data, out_size, true);
+    }
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (dev->addr << 1) | 1, true);
+    i2c_master_read(cmd, in_data, in_size, I2C_MASTER_LAST_NACK);
+}
+
+static void cmd_add_write(i2c_cmd_handle_t cmd, const i2c_dev_t *dev, const void *out_reg, size_t out_reg_size,
+        const void *out_data, size_t out_size)
+{
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, dev->addr << 1, true);
+    if (out_reg && out_reg_size)
+        i2c_master_write(cmd, (void *)out_reg, out_reg_size, true);
+    i2c_master_write(cmd, (void *)out_data, out_size, true);
+}
+
 esp_err_t i2c_dev_read(const i2c_dev_t *dev, const void *out_data, size_t out_size, void *in_data, size_t in_size)
 {
     if (!dev || !in_data || !in_size) return ESP_ERR_INVALID_ARG;
 
     SEMAPHORE_TAKE(dev->port);
 
-    esp_err_t res = i2c_setup_port(dev);
+    esp_err_t res = setup_dev(dev);
     if (res == ESP_OK)
     {
         i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-        if (out_data && out_size)
-        {
-            i2c_master_start(cmd);
-            i2c_master_write_byte(cmd, dev->addr << 1, true);
-            i2c_master_write(cmd, (void *)out_data, out_size, true);
-        }
-        i2c_master_start(cmd);
-        i2c_master_write_byte(cmd, (dev->addr << 1) | 1, true);
-        i2c_master_read(cmd, in_data, in_size, I2C_MASTER_LAST_NACK);
+        cmd_add_read(cmd, dev, out_data, out_size, in_data, in_size);
         i2c_master_stop(cmd);
 
-        res = i2c_master_cmd_begin(dev->port, cmd, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT));
+        res = cmd_begin(dev->port, dev, cmd, (out_data ? out_size : 0) + in_size);
         if (res != ESP_OK)
             ESP_LOGE(TAG, "Could not read from device [0x%02x at %d]: %d (%s)", dev->addr, dev->port, res, esp_err_to_name(res));
 
@@ -307,17 +621,13 @@ esp_err_t i2c_dev_write(const i2c_dev_t *dev, const void *out_reg, size_t out_re
 
     SEMAPHORE_TAKE(dev->port);
 
-    esp_err_t res = i2c_setup_port(dev);
+    esp_err_t res = setup_dev(dev);
     if (res == ESP_OK)
     {
         i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-        i2c_master_start(cmd);
-        i2c_master_write_byte(cmd, dev->addr << 1, true);
-        if (out_reg && out_reg_size)
-            i2c_master_write(cmd, (void *)out_reg, out_reg_size, true);
-        i2c_master_write(cmd, (void *)out_data, out_size, true);
+        cmd_add_write(cmd, dev, out_reg, out_reg_size, out_data, out_size);
         i2c_master_stop(cmd);
-        res = i2c_master_cmd_begin(dev->port, cmd, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT));
+        res = cmd_begin(dev->port, dev, cmd, (out_reg ? out_reg_size : 0) + out_size);
         if (res != ESP_OK)
             ESP_LOGE(TAG, "Could not write to device [0x%02x at %d]: %d (%s)", dev->addr, dev->port, res, esp_err_to_name(res));
         i2c_cmd_link_delete(cmd);
@@ -336,3 +646,381 @@ esp_err_t i2c_dev_write_reg(const i2c_dev_t *dev, uint8_t reg, const void *out_d
 {
     return i2c_dev_write(dev, &reg, 1, out_data, out_size);
 }
+
+esp_err_t i2c_dev_transfer(const i2c_dev_transfer_t *xfer)
+{
+    if (!xfer) return ESP_ERR_INVALID_ARG;
+
+    return xfer->type == I2C_DEV_READ
+        ? i2c_dev_read(xfer->dev, xfer->reg, xfer->reg_size, xfer->data, xfer->size)
+        : i2c_dev_write(xfer->dev, xfer->reg, xfer->reg_size, xfer->data, xfer->size);
+}
+
+esp_err_t i2c_dev_cmd_prepare(i2c_dev_cmd_t *cmd, const i2c_dev_transfer_t *xfer)
+{
+    if (!cmd || !xfer || !xfer->dev || !xfer->data || !xfer->size) return ESP_ERR_INVALID_ARG;
+    if (xfer->reg && xfer->reg_size > I2C_DEV_CMD_MAX_REG_SIZE) return ESP_ERR_INVALID_SIZE;
+    // list of a prepared command would be lost
+    if (cmd->cmd) return ESP_ERR_INVALID_STATE;
+
+    cmd->dev = xfer->dev;
+    cmd->type = xfer->type;
+    cmd->reg_size = xfer->reg ? xfer->reg_size : 0;
+    cmd->size = xfer->size;
+    if (cmd->reg_size)
+        memcpy(cmd->reg, xfer->reg, cmd->reg_size);
+
+#ifdef I2C_DEV_CMD_BUF_SIZE
+    cmd->cmd = i2c_cmd_link_create_static(cmd->buf, sizeof(cmd->buf));
+#else
+    cmd->cmd = i2c_cmd_link_create();
+#endif
+    if (!cmd->cmd)
+    {
+        ESP_LOGE(TAG, "[0x%02x at %d] Could not create command list", cmd->dev->addr, cmd->dev->port);
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (cmd->type == I2C_DEV_READ)
+        cmd_add_read(cmd->cmd, cmd->dev, cmd->reg, cmd->reg_size, xfer->data, xfer->size);
+    else
+        cmd_add_write(cmd->cmd, cmd->dev, cmd->reg, cmd->reg_size, xfer->data, xfer->size);
+    i2c_master_stop(cmd->cmd);
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_dev_cmd_exec(i2c_dev_cmd_t *cmd)
+{
+    if (!cmd || !cmd->cmd) return ESP_ERR_INVALID_ARG;
+
+    const i2c_dev_t *dev = cmd->dev;
+
+    SEMAPHORE_TAKE(dev->port);
+
+    esp_err_t res = setup_dev(dev);
+    if (res == ESP_OK)
+    {
+        res = cmd_begin(dev->port, dev, cmd->cmd, cmd->reg_size + cmd->size);
+        if (res != ESP_OK)
+            ESP_LOGE(TAG, "Could not execute command on device [0x%02x at %d]: %d (%s)", dev->addr, dev->port, res, esp_err_to_name(res));
+    }
+
+    SEMAPHORE_GIVE(dev->port);
+    return res;
+}
+
+esp_err_t i2c_dev_cmd_free(i2c_dev_cmd_t *cmd)
+{
+    if (!cmd) return ESP_ERR_INVALID_ARG;
+
+    if (cmd->cmd)
+    {
+#ifdef I2C_DEV_CMD_BUF_SIZE
+        i2c_cmd_link_delete_static(cmd->cmd);
+#else
+        i2c_cmd_link_delete(cmd->cmd);
+#endif
+        cmd->cmd = NULL;
+    }
+    return ESP_OK;
+}
+
+inline static bool same_bus_setup(const i2c_dev_t *a, const i2c_dev_t *b)
+{
+    return a->port == b->port
+        && a->timeout_ticks == b->timeout_ticks
+        && cfg_equal(&a->cfg, &b->cfg);
+}
+
+static inline size_t xfer_bytes(const i2c_dev_transfer_t *x)
+{
+    return (x->reg ? x->reg_size : 0) + x->size;
+}
+
+static esp_err_t batch_run(i2c_port_t port, const i2c_dev_transfer_t *xfers, size_t count,
+        i2c_cmd_handle_t cmd, size_t bytes)
+{
+    i2c_master_stop(cmd);
+#if CONFIG_I2CDEV_STATS
+    int64_t start = esp_timer_get_time();
+#endif
+    esp_err_t res = cmd_begin(port, NULL, cmd, bytes);
+#if CONFIG_I2CDEV_STATS
+    // Segment time is shared by its transfers in proportion to their size
+    uint32_t us = esp_timer_get_time() - start;
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t b = xfer_bytes(&xfers[i]);
+        dev_stats_add(xfers[i].dev, res, b, bytes ? (uint64_t)us * b / bytes : 0);
+    }
+#endif
+    if (res != ESP_OK)
+        ESP_LOGE(TAG, "Could not execute batch on port %d: %d (%s)", port, res, esp_err_to_name(res));
+    i2c_cmd_link_delete(cmd);
+    return res;
+}
+
+esp_err_t i2c_dev_transfer_batch(const i2c_dev_transfer_t *xfers, size_t count)
+{
+    if (!xfers || !count || !xfers[0].dev) return ESP_ERR_INVALID_ARG;
+
+    i2c_port_t port = xfers[0].dev->port;
+    if (port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+    for (size_t i = 0; i < count; i++)
+        if (!xfers[i].dev || xfers[i].dev->port != port || !xfers[i].data || !xfers[i].size)
+            return ESP_ERR_INVALID_ARG;
+
+    SEMAPHORE_TAKE(port);
+
+    esp_err_t res = ESP_OK;
+    i2c_cmd_handle_t cmd = NULL;
+    const i2c_dev_t *setup = NULL;
+    size_t bytes = 0;
+    size_t first = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        const i2c_dev_transfer_t *x = &xfers[i];
+
+        // Devices with different bus settings or behind another switch
+        // channel cannot share one command link
+        if (cmd && (!same_bus_setup(setup, x->dev) || mux_pending(x->dev)))
+        {
+            res = batch_run(port, xfers + first, i - first, cmd, bytes);
+            cmd = NULL;
+            if (res != ESP_OK)
+                break;
+        }
+        if (!cmd)
+        {
+            if ((res = setup_dev(x->dev)) != ESP_OK)
+                break;
+            if (!(cmd = i2c_cmd_link_create()))
+            {
+                res = ESP_ERR_NO_MEM;
+                break;
+            }
+            setup = x->dev;
+            bytes = 0;
+            first = i;
+        }
+        bytes += xfer_bytes(x);
+
+        if (x->type == I2C_DEV_READ)
+            cmd_add_read(cmd, x->dev, x->reg, x->reg_size, x->data, x->size);
+        else
+            cmd_add_write(cmd, x->dev, x->reg, x->reg_size, x->data, x->size);
+    }
+    if (cmd)
+        res = batch_run(port, xfers + first, count - first, cmd, bytes);
+
+    SEMAPHORE_GIVE(port);
+    return res;
+}
+
+#if !CONFIG_I2CDEV_NOLOCK
+
+static void async_worker(void *arg)
+{
+    QueueHandle_t queue = (QueueHandle_t)arg;
+    i2c_dev_async_t *trans;
+
+    while (true)
+    {
+        if (xQueueReceive(queue, &trans, portMAX_DELAY) != pdTRUE)
+            continue;
+
+        // Stop request has no device and is queued after all pending transfers
+        if (!trans->xfer.dev)
+        {
+            xSemaphoreGive((SemaphoreHandle_t)trans->ctx);
+            vTaskDelete(NULL);
+        }
+
+        // Callback may reuse the descriptor, so copy everything needed first
+        TaskHandle_t notify_task = trans->notify_task;
+        i2c_dev_async_cb_t callback = trans->callback;
+
+        trans->result = i2c_dev_transfer(&trans->xfer);
+        trans->done = true;
+
+        if (callback)
+            callback(trans);
+        if (notify_task)
+            xTaskNotifyGive(notify_task);
+    }
+}
+
+// Must be called with port locked
+static esp_err_t async_start(i2c_port_t port)
+{
+    ESP_LOGD(TAG, "Starting asynchronous worker on port %d", port);
+    states[port].queue = xQueueCreate(CONFIG_I2CDEV_ASYNC_QUEUE_SIZE, sizeof(i2c_dev_async_t *));
+    if (states[port].queue
+        && xTaskCreate(async_worker, "i2cdev", CONFIG_I2CDEV_ASYNC_TASK_STACK_SIZE, states[port].queue,
+                CONFIG_I2CDEV_ASYNC_TASK_PRIORITY, &states[port].worker) == pdPASS)
+        return ESP_OK;
+
+    if (states[port].queue)
+        vQueueDelete(states[port].queue);
+    states[port].queue = NULL;
+    states[port].worker = NULL;
+    ESP_LOGE(TAG, "Could not start asynchronous worker on port %d", port);
+    return ESP_ERR_NO_MEM;
+}
+
+#endif
+
+static esp_err_t async_stop(i2c_port_t port)
+{
+    SemaphoreHandle_t stopped = xSemaphoreCreateBinary();
+    if (!stopped)
+        return ESP_ERR_NO_MEM;
+
+    ESP_LOGD(TAG, "Stopping asynchronous worker on port %d", port);
+    i2c_dev_async_t stop = { .ctx = stopped };
+    i2c_dev_async_t *trans = &stop;
+    xQueueSend(states[port].queue, &trans, portMAX_DELAY);
+    xSemaphoreTake(stopped, portMAX_DELAY);
+    vSemaphoreDelete(stopped);
+
+    vQueueDelete(states[port].queue);
+    states[port].queue = NULL;
+    states[port].worker = NULL;
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_dev_submit(i2c_dev_async_t *trans)
+{
+#if CONFIG_I2CDEV_NOLOCK
+    // worker would access the bus concurrently with synchronous callers
+    return ESP_ERR_NOT_SUPPORTED;
+#else
+    if (!trans || !trans->xfer.dev || !trans->xfer.data || !trans->xfer.size)
+        return ESP_ERR_INVALID_ARG;
+
+    i2c_port_t port = trans->xfer.dev->port;
+    if (port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+
+    // Worker is started once even if several tasks submit at the same time
+    SEMAPHORE_TAKE(port);
+    esp_err_t res = states[port].worker ? ESP_OK : async_start(port);
+    QueueHandle_t queue = states[port].queue;
+    SEMAPHORE_GIVE(port);
+    if (res != ESP_OK)
+        return res;
+
+    trans->done = false;
+    trans->result = ESP_OK;
+    if (xQueueSend(queue, &trans, 0) != pdTRUE)
+    {
+        ESP_LOGE(TAG, "[0x%02x at %d] Asynchronous queue is full", trans->xfer.dev->addr, port);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    return ESP_OK;
+#endif
+}
+
+esp_err_t i2cdev_get_port_stats(i2c_port_t port, i2c_port_stats_t *stats)
+{
+#if CONFIG_I2CDEV_STATS
+    if (port >= I2C_NUM_MAX || !stats) return ESP_ERR_INVALID_ARG;
+
+    SEMAPHORE_TAKE(port);
+    memcpy(stats, &states[port].stats, sizeof(i2c_port_stats_t));
+    SEMAPHORE_GIVE(port);
+
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t i2cdev_reset_port_stats(i2c_port_t port)
+{
+#if CONFIG_I2CDEV_STATS
+    if (port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+
+    SEMAPHORE_TAKE(port);
+    memset(&states[port].stats, 0, sizeof(i2c_port_stats_t));
+    SEMAPHORE_GIVE(port);
+
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t i2c_dev_get_stats(const i2c_dev_t *dev, i2c_dev_stats_t *stats)
+{
+#if CONFIG_I2CDEV_STATS
+    if (!dev || dev->port >= I2C_NUM_MAX || !stats) return ESP_ERR_INVALID_ARG;
+
+    SEMAPHORE_TAKE(dev->port);
+    const dev_stats_t *e = dev_stats(dev, false);
+    if (e)
+        memcpy(stats, &e->stats, sizeof(i2c_dev_stats_t));
+    else
+        memset(stats, 0, sizeof(i2c_dev_stats_t));
+    SEMAPHORE_GIVE(dev->port);
+
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t i2c_dev_reset_stats(const i2c_dev_t *dev)
+{
+#if CONFIG_I2CDEV_STATS
+    if (!dev || dev->port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+
+    SEMAPHORE_TAKE(dev->port);
+    // free the entry for other devices
+    dev_stats_t *e = dev_stats(dev, false);
+    if (e)
+        memset(e, 0, sizeof(dev_stats_t));
+    SEMAPHORE_GIVE(dev->port);
+
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t i2c_dev_set_mux(i2c_dev_t *dev, uint8_t mux_addr, uint8_t channel)
+{
+    if (!dev || (mux_addr && !mux_valid(mux_addr, channel))) return ESP_ERR_INVALID_ARG;
+
+    dev->mux_addr = mux_addr;
+    dev->mux_channel = mux_addr ? channel : 0;
+
+    return ESP_OK;
+}
+
+esp_err_t i2cdev_mux_select(const i2c_dev_t *mux, uint8_t channels)
+{
+    if (!mux || mux->port >= I2C_NUM_MAX || !mux_valid(mux->addr, 0)) return ESP_ERR_INVALID_ARG;
+
+    SEMAPHORE_TAKE(mux->port);
+
+    esp_err_t res = setup_dev(mux);
+    if (res == ESP_OK)
+        res = mux_write(mux->port, mux->addr, channels);
+
+    SEMAPHORE_GIVE(mux->port);
+    return res;
+}
+
+esp_err_t i2cdev_mux_invalidate(i2c_port_t port)
+{
+    if (port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+
+    SEMAPHORE_TAKE(port);
+    states[port].mux_known = 0;
+    SEMAPHORE_GIVE(port);
+
+    return ESP_OK;
+}
@@ -38,6 +38,7 @@
 #include <driver/i2c.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
+#include <freertos/task.h>
 #include <esp_err.h>
 #include <esp_idf_lib_helpers.h>
 
@@ -62,6 +63,42 @@ extern "C" {
 
 #endif /* HELPER_TARGET_IS_ESP8266 */
 
+/**
+ * Number of buckets in latency histogram
+ */
+#define I2CDEV_STATS_HIST_SIZE 10
+
+/**
+ * Transaction statistics
+ */
+typedef struct
+{
+    uint32_t transactions;                  //!< Number of executed transactions
+    uint32_t nacks;                         //!< Transactions failed because of NACK
+    uint32_t timeouts;                      //!< Transactions failed because of timeout
+    uint32_t errors;                        //!< Transactions failed for other reasons
+    uint64_t bytes;                         //!< Transferred data bytes, not including address bytes
+    uint64_t busy_us;                       //!< Total transaction time, us
+    uint32_t max_us;                        //!< Longest transaction time, us
+    uint32_t hist[I2CDEV_STATS_HIST_SIZE];  /*!< Transaction time histogram. Bucket N counts transactions
+                                                 shorter than 64 << N us, last bucket counts all longer ones */
+} i2c_dev_stats_t;
+
+/**
+ * Port statistics
+ */
+typedef struct
+{
+    i2c_dev_stats_t xfer;      //!< Statistics of all transactions on port
+    uint32_t lock_waits;       //!< Number of port lock acquisitions
+    uint32_t lock_timeouts;    //!< Number of failed port lock acquisitions
+    uint64_t lock_wait_us;     //!< Total time spent waiting for port lock, us
+    uint32_t lock_wait_max_us; //!< Longest wait for port lock, us
+    uint32_t reinstalls;       //!< Number of driver reinstallations because of different device configurations
+    uint32_t clock_switches;   //!< Number of clock speed changes without driver reinstallation
+    uint32_t mux_switches;     //!< Number of I2C switch channel changes
+} i2c_port_stats_t;
+
 /**
  * I2C device descriptor
  */
@@ -74,6 +111,8 @@ typedef struct
     uint32_t timeout_ticks;  /*!< HW I2C bus timeout (stretch time), in ticks. 80MHz APB clock
                                   ticks for ESP-IDF, CPU ticks for ESP8266.
                                   When this value is 0, I2CDEV_MAX_STRETCH_TIME will be used */
+    uint8_t mux_addr;        //!< Address of TCA9548-compatible I2C switch the device is connected to, 0 if none
+    uint8_t mux_channel;     //!< Channel of I2C switch, 0..7
 } i2c_dev_t;
 
 /**
@@ -84,6 +123,78 @@ typedef enum {
     I2C_DEV_READ       /**< Read operation */
 } i2c_dev_type_t;
 
+/**
+ * Single I2C transfer to or from a device register
+ */
+typedef struct
+{
+    const i2c_dev_t *dev; //!< Device descriptor
+    i2c_dev_type_t type;  //!< Transfer direction
+    const void *reg;      //!< Pointer to register address to send before data, may be NULL
+    size_t reg_size;      //!< Size of register address
+    void *data;           //!< Data buffer: input for I2C_DEV_READ, output for I2C_DEV_WRITE
+    size_t size;          //!< Size of data
+} i2c_dev_transfer_t;
+
+#if defined(I2C_LINK_RECOMMENDED_SIZE) || defined(__DOXYGEN__)
+/**
+ * Size of static command list buffer in prepared command descriptor
+ */
+#define I2C_DEV_CMD_BUF_SIZE I2C_LINK_RECOMMENDED_SIZE(2)
+#endif
+
+/**
+ * Maximal size of register address in prepared command descriptor
+ */
+#define I2C_DEV_CMD_MAX_REG_SIZE 4
+
+/**
+ * Prepared command descriptor
+ *
+ * Holds a driver command list built once by ::i2c_dev_cmd_prepare() and
+ * executed any number of times by ::i2c_dev_cmd_exec(). Prepared descriptor
+ * must not be copied or moved. When the driver
+ * supports static command lists (ESP-IDF >= 4.4) the list is built in the
+ * descriptor itself, so neither preparation nor execution allocate memory.
+ */
+typedef struct
+{
+    const i2c_dev_t *dev;                   //!< Device descriptor
+    i2c_dev_type_t type;                    //!< Transfer direction
+    uint8_t reg[I2C_DEV_CMD_MAX_REG_SIZE];  //!< Copy of register address
+    size_t reg_size;                        //!< Size of register address
+    size_t size;                            //!< Size of data
+    i2c_cmd_handle_t cmd;                   //!< Driver command list, NULL if not prepared
+#ifdef I2C_DEV_CMD_BUF_SIZE
+    uint8_t buf[I2C_DEV_CMD_BUF_SIZE];      //!< Static command list storage
+#endif
+} i2c_dev_cmd_t;
+
+typedef struct i2c_dev_async i2c_dev_async_t;
+
+/**
+ * Asynchronous transfer completion callback.
+ *
+ * Called from the port worker task, must not block for long.
+ */
+typedef void (*i2c_dev_async_cb_t)(i2c_dev_async_t *trans);
+
+/**
+ * Asynchronous transfer descriptor
+ *
+ * Descriptor and all buffers it points to must stay valid until the transfer
+ * is completed.
+ */
+struct i2c_dev_async
+{
+    i2c_dev_transfer_t xfer;     //!< Transfer to execute
+    i2c_dev_async_cb_t callback; //!< Completion callback, may be NULL
+    void *ctx;                   //!< User context
+    TaskHandle_t notify_task;    //!< Task to notify with xTaskNotifyGive() on completion, may be NULL
+    volatile bool done;          //!< true when transfer is completed
+    volatile esp_err_t result;   //!< Transfer result, valid when done is true
+};
+
 /**
  * @brief Init library
  *
@@ -97,7 +208,9 @@ esp_err_t i2cdev_init();
 /**
  * @brief Finish work with library
  *
- * Uninstall i2c drivers.
+ * Uninstall i2c drivers and stop asynchronous workers.
+ * Transfers already submitted are executed before workers are stopped.
+ * No transfers must be submitted during this call.
  *
  * @return ESP_OK on success
  */
@@ -215,6 +328,191 @@ esp_err_t i2c_dev_read_reg(const i2c_dev_t *dev, uint8_t reg,
 esp_err_t i2c_dev_write_reg(const i2c_dev_t *dev, uint8_t reg,
         const void *out_data, size_t out_size);
 
+/**
+ * @brief Execute single transfer
+ *
+ * Shortcut to ::i2c_dev_read() or ::i2c_dev_write() depending on transfer type.
+ *
+ * @param xfer Transfer descriptor
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_transfer(const i2c_dev_transfer_t *xfer);
+
+/**
+ * @brief Execute list of transfers as one batch
+ *
+ * All transfers are executed under a single port lock. Consecutive transfers
+ * to devices with the same bus configuration are joined with repeated START
+ * conditions into a single driver command list, so a batch to devices with
+ * identical settings costs one driver submission. Transfers may belong to
+ * different devices, but all devices must be on the same port.
+ *
+ * Batch is aborted on the first failed command list. Since the whole command
+ * list fails at once, it is not possible to tell which transfer in it failed.
+ * Do not batch transfers that require a delay between them (e.g. a measurement
+ * command followed by reading the result).
+ *
+ * Device mutexes are not taken by this function.
+ *
+ * @param xfers Array of transfer descriptors
+ * @param count Number of transfers
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_transfer_batch(const i2c_dev_transfer_t *xfers, size_t count);
+
+/**
+ * @brief Prepare reusable command
+ *
+ * Build driver command list for the transfer once. Register address is copied
+ * into the descriptor, data buffer is referenced and must stay valid while
+ * the command is prepared: for I2C_DEV_READ transfers received data is
+ * placed into it on each execution, for I2C_DEV_WRITE transfers its content
+ * must not be changed after preparation.
+ *
+ * Descriptor must be zero-initialized or released with ::i2c_dev_cmd_free()
+ * before preparation. Command list references register address inside the
+ * descriptor, so prepared descriptor must not be copied or moved.
+ *
+ * @param cmd Command descriptor
+ * @param xfer Transfer to prepare
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if descriptor is already prepared
+ */
+esp_err_t i2c_dev_cmd_prepare(i2c_dev_cmd_t *cmd, const i2c_dev_transfer_t *xfer);
+
+/**
+ * @brief Execute prepared command
+ *
+ * Function is thread-safe.
+ *
+ * @param cmd Prepared command descriptor
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_cmd_exec(i2c_dev_cmd_t *cmd);
+
+/**
+ * @brief Release prepared command
+ *
+ * After this call the descriptor can be prepared again.
+ *
+ * @param cmd Command descriptor
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_cmd_free(i2c_dev_cmd_t *cmd);
+
+/**
+ * @brief Queue transfer for asynchronous execution
+ *
+ * Transfer is placed in the queue of the device port and executed by the port
+ * worker task, so the caller does not wait for the bus. Worker task is created
+ * on first call for the port. Transfers on the same port are executed in
+ * order of submission.
+ *
+ * When transfer is completed, `trans->done` is set, `trans->callback` is called
+ * and `trans->notify_task` is notified. Notifications are counting, so a task
+ * that submitted N transfers can wait for them with N calls of ulTaskNotifyTake().
+ *
+ * @note Asynchronous transfers are not supported when CONFIG_I2CDEV_NOLOCK
+ *       is enabled, because the worker would access the bus concurrently
+ *       with synchronous callers.
+ *
+ * @param trans Asynchronous transfer descriptor
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT if the port queue is full,
+ *         ESP_ERR_NOT_SUPPORTED if CONFIG_I2CDEV_NOLOCK is enabled
+ */
+esp_err_t i2c_dev_submit(i2c_dev_async_t *trans);
+
+/**
+ * @brief Bind device to a channel of I2C switch
+ *
+ * Devices behind TCA9548-compatible I2C switches (addresses 0x70..0x77)
+ * are accessed as if they were connected to the bus directly: before every
+ * transaction i2cdev selects the device channel on the switch, under the same
+ * port lock. Current channels of each switch are cached per port, so the
+ * switch is written only when the channel actually changes. When a channel
+ * is selected, channels of other switches with known state are disconnected.
+ * Nested switches are not supported.
+ *
+ * @param dev Device descriptor
+ * @param mux_addr Address of I2C switch, 0 to access the device directly
+ * @param channel Channel number, 0..7
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_set_mux(i2c_dev_t *dev, uint8_t mux_addr, uint8_t channel);
+
+/**
+ * @brief Set channels of I2C switch
+ *
+ * Write channel flags to the switch and update the channel cache.
+ * Switches must be controlled through this function (or ::i2cdev_mux_invalidate()
+ * must be called after direct writes), otherwise the cache becomes stale.
+ *
+ * @param mux Descriptor of I2C switch
+ * @param channels Channel flags, bit N enables channel N
+ * @return ESP_OK on success
+ */
+esp_err_t i2cdev_mux_select(const i2c_dev_t *mux, uint8_t channels);
+
+/**
+ * @brief Forget cached channels of all I2C switches on port
+ *
+ * Next access to a device behind a switch will write the switch.
+ *
+ * @param port I2C port
+ * @return ESP_OK on success
+ */
+esp_err_t i2cdev_mux_invalidate(i2c_port_t port);
+
+/**
+ * @brief Get port statistics
+ *
+ * Option CONFIG_I2CDEV_STATS must be enabled.
+ *
+ * @param port I2C port
+ * @param[out] stats Snapshot of port statistics
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if statistics are disabled
+ */
+esp_err_t i2cdev_get_port_stats(i2c_port_t port, i2c_port_stats_t *stats);
+
+/**
+ * @brief Reset port statistics
+ *
+ * Option CONFIG_I2CDEV_STATS must be enabled.
+ *
+ * @param port I2C port
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if statistics are disabled
+ */
+esp_err_t i2cdev_reset_port_stats(i2c_port_t port);
+
+/**
+ * @brief Get device statistics
+ *
+ * Option CONFIG_I2CDEV_STATS must be enabled. Each transfer executed by
+ * ::i2c_dev_transfer_batch() is accounted as a transaction of its device
+ * with a share of the batch time proportional to the transfer size.
+ *
+ * Statistics are kept by the port for up to CONFIG_I2CDEV_STATS_DEVICES
+ * devices identified by address and I2C switch channel, so descriptors of
+ * the same device share them. Transactions of further devices are counted
+ * in port statistics only. Zeroed statistics are returned for devices
+ * without transactions.
+ *
+ * @param dev Device descriptor
+ * @param[out] stats Snapshot of device statistics
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if statistics are disabled
+ */
+esp_err_t i2c_dev_get_stats(const i2c_dev_t *dev, i2c_dev_stats_t *stats);
+
+/**
+ * @brief Reset device statistics
+ *
+ * Option CONFIG_I2CDEV_STATS must be enabled. Statistics entry of the
+ * device is released for other devices.
+ *
+ * @param dev Device descriptor
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if statistics are disabled
+ */
+esp_err_t i2c_dev_reset_stats(const i2c_dev_t *dev);
+
 #define I2C_DEV_TAKE_MUTEX(dev) do { \
         esp_err_t __ = i2c_dev_take_mutex(dev); \
         if (__ != ESP_OK) return __;\
@@ -32,6 +32,7 @@
  *
  */
 
+#include <string.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <esp_log.h>
@@ -262,17 +263,17 @@ static inline esp_err_t read_register(icm42670_t *dev, uint8_t reg, uint8_t *val
     return i2c_dev_read_reg(&dev->i2c_dev, reg, value, 1);
 }
 
-static inline esp_err_t read_register_16(icm42670_t *dev, uint8_t upper_byte_reg, int16_t *value)
+static esp_err_t prepare_raw_cmd(icm42670_t *dev, uint8_t data_register)
 {
-    CHECK_ARG(dev && value);
-
-    esp_err_t err;
-    uint8_t reg_0, reg_1;
-    err = read_register(dev, upper_byte_reg, &reg_1);
-    err = read_register(dev, upper_byte_reg + 1, &reg_0);
-    *value = reg_0 | (reg_1 << 8);
-
-    return err;
+    i2c_dev_transfer_t xfer = {
+        .dev = &dev->i2c_dev,
+        .type = I2C_DEV_READ,
+        .reg = &data_register,
+        .reg_size = 1,
+        .data = dev->raw_buf,
+        .size = sizeof(dev->raw_buf)
+    };
+    return i2c_dev_cmd_prepare(&dev->raw_cmd, &xfer);
 }
 
 static inline esp_err_t manipulate_register(icm42670_t *dev, uint8_t reg_addr, uint8_t mask, uint8_t shift,
@@ -371,6 +372,9 @@ esp_err_t icm42670_init_desc(icm42670_t *dev, uint8_t addr, i2c_port_t port, gpi
     dev->i2c_dev.cfg.master.clk_speed = I2C_FREQ_HZ;
 #endif
 
+    memset(&dev->raw_cmd, 0, sizeof(dev->raw_cmd));
+    CHECK(prepare_raw_cmd(dev, ICM42670_REG_TEMP_DATA1));
+
     return i2c_dev_create_mutex(&dev->i2c_dev);
 }
 
@@ -378,6 +382,8 @@ esp_err_t icm42670_free_desc(icm42670_t *dev)
 {
     CHECK_ARG(dev);
 
+    CHECK(i2c_dev_cmd_free(&dev->raw_cmd));
+
     return i2c_dev_delete_mutex(&dev->i2c_dev);
 }
 
@@ -493,7 +499,14 @@ esp_err_t icm42670_read_raw_data(icm42670_t *dev, uint8_t data_register, int16_t
     CHECK_ARG(dev && data);
 
     I2C_DEV_TAKE_MUTEX(&dev->i2c_dev);
-    I2C_DEV_CHECK(&dev->i2c_dev, read_register_16(dev, data_register, data));
+    if (dev->raw_cmd.reg[0] != data_register)
+    {
+        I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_cmd_free(&dev->raw_cmd));
+        I2C_DEV_CHECK(&dev->i2c_dev, prepare_raw_cmd(dev, data_register));
+    }
+    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_cmd_exec(&dev->raw_cmd));
+    // decode before giving the mutex, buffer is shared by all callers
+    *data = (int16_t)(dev->raw_buf[1] | (dev->raw_buf[0] << 8));
     I2C_DEV_GIVE_MUTEX(&dev->i2c_dev);
 
     return ESP_OK;
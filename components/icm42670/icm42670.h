@@ -356,6 +356,8 @@ typedef enum {
 typedef struct
 {
     i2c_dev_t i2c_dev;
+    i2c_dev_cmd_t raw_cmd; // prepared read of 16-bit raw data register
+    uint8_t raw_buf[2];    // raw data of raw_cmd
     // TODO: add more vars for configuration
 } icm42670_t;
 
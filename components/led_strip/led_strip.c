@@ -34,6 +34,7 @@
 #include <esp_log.h>
 #include <esp_attr.h>
 #include <stdlib.h>
+#include <string.h>
 #include <ets_sys.h>
 #include <esp_idf_lib_helpers.h>
 
@@ -69,6 +70,7 @@ static const char *TAG = "led_strip";
 #define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
 
 #define COLOR_SIZE(strip) (3 + ((strip)->is_rgbw != 0))
+#define FRAME_COUNT(strip) ((strip)->buffers ? (strip)->buffers : 1)
 
 static void IRAM_ATTR _rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
                                    size_t wanted_num, size_t *translated_size, size_t *item_num,
@@ -116,6 +118,9 @@ typedef struct {
 
 static led_rmt_t rmt_items[LED_STRIP_TYPE_MAX] = { 0 };
 
+// RMT items for every nibble value, MSB first
+static rmt_item32_t nibble_items[LED_STRIP_TYPE_MAX][16][4] = { 0 };
+
 static void IRAM_ATTR ws2812_rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
         size_t wanted_num, size_t *translated_size, size_t *item_num)
 {
@@ -158,6 +163,23 @@ static const led_params_t led_params[] = {
     [LED_STRIP_SM16703] = { .t0h = 300, .t0l = 900,  .t1h = 1360, .t1l = 350, .order = ORDER_RGB, .adapter = sm16703_rmt_adapter },
 };
 
+static esp_err_t setup_channel(led_strip_t *strip)
+{
+    rmt_config_t config = RMT_DEFAULT_CONFIG_TX(strip->gpio, strip->channel);
+    config.clk_div = LED_STRIP_RMT_CLK_DIV;
+
+    CHECK(rmt_config(&config));
+    CHECK(rmt_driver_install(config.channel, 0, 0));
+
+    CHECK(rmt_translator_init(config.channel, led_params[strip->type].adapter));
+#ifdef LED_STRIP_BRIGHTNESS
+    // No support for translator context prior to ESP-IDF 4.3
+    CHECK(rmt_translator_set_context(config.channel, strip));
+#endif
+
+    return ESP_OK;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 void led_strip_install()
@@ -176,53 +198,102 @@ void led_strip_install()
         rmt_items[i].bit1.level0 = 1;
         rmt_items[i].bit1.duration1 = (uint32_t)(ratio * led_params[i].t1l);
         rmt_items[i].bit1.level1 = 0;
+
+        for (size_t n = 0; n < 16; n++)
+            for (size_t bit = 0; bit < 4; bit++)
+                nibble_items[i][n][bit] = n & (1 << (3 - bit)) ? rmt_items[i].bit1 : rmt_items[i].bit0;
     }
 }
 
 esp_err_t led_strip_init(led_strip_t *strip)
 {
-    CHECK_ARG(strip && strip->length > 0 && strip->type < LED_STRIP_TYPE_MAX);
-
-    strip->buf = calloc(strip->length, COLOR_SIZE(strip));
-    if (!strip->buf)
+    CHECK_ARG(strip && strip->length > 0 && strip->type < LED_STRIP_TYPE_MAX
+              && strip->buffers <= LED_STRIP_MAX_BUFFERS);
+
+    strip->frames = calloc(strip->length * FRAME_COUNT(strip), COLOR_SIZE(strip));
+    strip->buf = strip->frames;
+    strip->back = 0;
+    strip->items = strip->encoded
+        ? calloc(strip->length * COLOR_SIZE(strip) * 8, sizeof(rmt_item32_t))
+        : NULL;
+    if (!strip->buf || (strip->encoded && !strip->items))
     {
         ESP_LOGE(TAG, "Not enough memory");
+        free(strip->frames);
+        free(strip->items);
+        strip->frames = NULL;
+        strip->buf = NULL;
+        strip->items = NULL;
         return ESP_ERR_NO_MEM;
     }
 
-    rmt_config_t config = RMT_DEFAULT_CONFIG_TX(strip->gpio, strip->channel);
-    config.clk_div = LED_STRIP_RMT_CLK_DIV;
-
-    CHECK(rmt_config(&config));
-    CHECK(rmt_driver_install(config.channel, 0, 0));
-
-    CHECK(rmt_translator_init(config.channel, led_params[strip->type].adapter));
-#ifdef LED_STRIP_BRIGHTNESS
-    // No support for translator context prior to ESP-IDF 4.3
-    CHECK(rmt_translator_set_context(config.channel, strip));
-#endif
-
-    return ESP_OK;
+    return setup_channel(strip);
 }
 
 esp_err_t led_strip_free(led_strip_t *strip)
 {
     CHECK_ARG(strip && strip->buf);
-    free(strip->buf);
+    free(strip->frames);
+    free(strip->items);
+    strip->frames = NULL;
+    strip->buf = NULL;
+    strip->items = NULL;
 
     CHECK(rmt_driver_uninstall(strip->channel));
 
     return ESP_OK;
 }
 
+static void encode(led_strip_t *strip)
+{
+    const rmt_item32_t (*lut)[4] = nibble_items[strip->type];
+    size_t size = strip->length * COLOR_SIZE(strip);
+    rmt_item32_t *dest = strip->items;
+
+    // brightness is already applied by put_pixels()
+    for (size_t i = 0; i < size; i++, dest += 8)
+    {
+        uint8_t b = strip->buf[i];
+        memcpy(dest, lut[b >> 4], sizeof(lut[0]));
+        memcpy(dest + 4, lut[b & 0x0f], sizeof(lut[0]));
+    }
+}
+
+static esp_err_t start_frame(led_strip_t *strip)
+{
+    if (strip->encoded)
+        return rmt_write_items(strip->channel, strip->items,
+                               strip->length * COLOR_SIZE(strip) * 8, false);
+    return rmt_write_sample(strip->channel, strip->buf,
+                            strip->length * COLOR_SIZE(strip), false);
+}
+
 esp_err_t led_strip_flush(led_strip_t *strip)
 {
     CHECK_ARG(strip && strip->buf);
 
     CHECK(rmt_wait_tx_done(strip->channel, pdMS_TO_TICKS(CONFIG_LED_STRIP_FLUSH_TIMEOUT)));
+    if (strip->encoded)
+        encode(strip);
     ets_delay_us(CONFIG_LED_STRIP_PAUSE_LENGTH);
-    return rmt_write_sample(strip->channel, strip->buf,
-                            strip->length * COLOR_SIZE(strip), false);
+    return start_frame(strip);
+}
+
+// Transmission reads from the presented buffer, give the next one to the application
+static void next_buffer(led_strip_t *strip)
+{
+    strip->back = (strip->back + 1) % FRAME_COUNT(strip);
+    strip->buf = strip->frames + strip->back * strip->length * COLOR_SIZE(strip);
+}
+
+esp_err_t led_strip_present(led_strip_t *strip)
+{
+    CHECK_ARG(strip && strip->buf);
+
+    CHECK(led_strip_flush(strip));
+    next_buffer(strip);
+
+    return ESP_OK;
 }
 
 bool led_strip_busy(led_strip_t *strip)
@@ -238,35 +309,58 @@ esp_err_t led_strip_wait(led_strip_t *strip, TickType_t timeout)
     return rmt_wait_tx_done(strip->channel, timeout);
 }
 
-esp_err_t led_strip_set_pixel(led_strip_t *strip, size_t num, rgb_t color)
+// Convert len pixels from src (walking by step) into strip buffer at dst.
+// Color order and W channel are resolved once per call, not per pixel.
+#define PUT_PIXELS(C0, C1, C2, RGBW) \
+    for (; len; len--, src += step, dst += 3 + (RGBW)) \
+    { \
+        rgb_t c = lut ? rgb_lut_apply(lut, *src) : *src; \
+        if (brightness != 255) c = rgb_scale_video(c, brightness); \
+        dst[0] = c.C0; \
+        dst[1] = c.C1; \
+        dst[2] = c.C2; \
+        if (RGBW) dst[3] = rgb_luma(c); \
+    }
+
+static void put_pixels(led_strip_t *strip, uint8_t *dst, const rgb_t *src, size_t len, int step)
 {
-    CHECK_ARG(strip && strip->buf && num <= strip->length);
-    size_t idx = num * COLOR_SIZE(strip);
-    switch (led_params[strip->type].order)
+    const rgb_lut_t *lut = strip->lut;
+#ifdef LED_STRIP_BRIGHTNESS
+    // Encoded frames are not scaled in flush, so scale pixels here
+    uint8_t brightness = strip->encoded ? strip->brightness : 255;
+#else
+    uint8_t brightness = 255;
+#endif
+
+    if (led_params[strip->type].order == ORDER_GRB)
     {
-        case ORDER_GRB:
-            strip->buf[idx] = color.g;
-            strip->buf[idx + 1] = color.r;
-            strip->buf[idx + 2] = color.b;
-            if (strip->is_rgbw)
-                strip->buf[idx + 3] = rgb_luma(color);
-            break;
-        case ORDER_RGB:
-            strip->buf[idx] = color.r;
-            strip->buf[idx + 1] = color.g;
-            strip->buf[idx + 2] = color.b;
-            if (strip->is_rgbw)
-                strip->buf[idx + 3] = rgb_luma(color);
-            break;
+        if (strip->is_rgbw)
+            PUT_PIXELS(g, r, b, 1)
+        else
+            PUT_PIXELS(g, r, b, 0)
     }
+    else
+    {
+        if (strip->is_rgbw)
+            PUT_PIXELS(r, g, b, 1)
+        else
+            PUT_PIXELS(r, g, b, 0)
+    }
+}
+
+esp_err_t led_strip_set_pixel(led_strip_t *strip, size_t num, rgb_t color)
+{
+    CHECK_ARG(strip && strip->buf && num < strip->length);
+
+    put_pixels(strip, strip->buf + num * COLOR_SIZE(strip), &color, 1, 0);
     return ESP_OK;
 }
 
 esp_err_t led_strip_set_pixels(led_strip_t *strip, size_t start, size_t len, rgb_t *data)
 {
-    CHECK_ARG(strip && strip->buf && len && start + len <= strip->length);
-    for (size_t i = 0; i < len; i++)
-        CHECK(led_strip_set_pixel(strip, i + start, data[i]));
+    CHECK_ARG(strip && strip->buf && data && len && start + len <= strip->length);
+
+    put_pixels(strip, strip->buf + start * COLOR_SIZE(strip), data, len, 1);
     return ESP_OK;
 }
 
@@ -274,7 +368,130 @@ esp_err_t led_strip_fill(led_strip_t *strip, size_t start, size_t len, rgb_t col
 {
     CHECK_ARG(strip && strip->buf && len && start + len <= strip->length);
 
-    for (size_t i = start; i < start + len; i++)
-        CHECK(led_strip_set_pixel(strip, i, color));
+    // encode color once, then replicate already encoded pixels doubling the copied span
+    size_t pixel_size = COLOR_SIZE(strip);
+    uint8_t *dst = strip->buf + start * pixel_size;
+    size_t total = len * pixel_size;
+    put_pixels(strip, dst, &color, 1, 0);
+    for (size_t done = pixel_size; done < total; done *= 2)
+        memcpy(dst + done, dst, done < total - done ? done : total - done);
+
+    return ESP_OK;
+}
+
+esp_err_t led_strip_blit(led_strip_t *strip, size_t start, const rgb_t *data, size_t width, size_t height,
+                         bool serpentine)
+{
+    CHECK_ARG(strip && strip->buf && data && width && height
+              && start + width * height <= strip->length);
+
+    size_t row_size = width * COLOR_SIZE(strip);
+    uint8_t *dst = strip->buf + start * COLOR_SIZE(strip);
+    const rgb_t *src = data;
+    for (size_t y = 0; y < height; y++, src += width, dst += row_size)
+    {
+        if (serpentine && (y & 1))
+            put_pixels(strip, dst, src + width - 1, width, -1);
+        else
+            put_pixels(strip, dst, src, width, 1);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t led_strip_group_init(led_strip_group_t *group)
+{
+    CHECK_ARG(group && group->strips && group->count);
+    for (size_t i = 0; i < group->count; i++)
+        CHECK_ARG(group->strips[i] && group->strips[i]->buf);
+
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    for (size_t i = 0; i < group->count; i++)
+        CHECK(rmt_add_channel_to_group(group->strips[i]->channel));
+#endif
+
+    return ESP_OK;
+}
+
+esp_err_t led_strip_group_free(led_strip_group_t *group)
+{
+    CHECK_ARG(group && group->strips && group->count);
+
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    for (size_t i = 0; i < group->count; i++)
+        CHECK(rmt_remove_channel_from_group(group->strips[i]->channel));
+#endif
+
+    return ESP_OK;
+}
+
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+// Synchronized channels transmit only when all of them are started, so
+// channels started before a failure are stopped and reinstalled (driver
+// would wait for the end of their transmission forever) and the group
+// is rebuilt
+static void group_abort(led_strip_group_t *group, size_t started)
+{
+    for (size_t i = 0; i < started; i++)
+    {
+        led_strip_t *strip = group->strips[i];
+        rmt_tx_stop(strip->channel);
+        rmt_driver_uninstall(strip->channel);
+        if (setup_channel(strip) != ESP_OK)
+            ESP_LOGE(TAG, "Could not reset RMT channel %d", strip->channel);
+    }
+    for (size_t i = 0; i < group->count; i++)
+        rmt_remove_channel_from_group(group->strips[i]->channel);
+    for (size_t i = 0; i < group->count; i++)
+        rmt_add_channel_to_group(group->strips[i]->channel);
+}
+#endif
+
+esp_err_t led_strip_group_flush(led_strip_group_t *group)
+{
+    CHECK_ARG(group && group->strips && group->count);
+
+    CHECK(led_strip_group_wait(group, pdMS_TO_TICKS(CONFIG_LED_STRIP_FLUSH_TIMEOUT)));
+
+    // Encode everything first to start channels as close as possible
+    for (size_t i = 0; i < group->count; i++)
+        if (group->strips[i]->encoded)
+            encode(group->strips[i]);
+
+    ets_delay_us(CONFIG_LED_STRIP_PAUSE_LENGTH);
+    for (size_t i = 0; i < group->count; i++)
+    {
+        esp_err_t res = start_frame(group->strips[i]);
+        if (res != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Could not start strip #%u of group: %d (%s)", (unsigned)i, res, esp_err_to_name(res));
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+            group_abort(group, i);
+#endif
+            return res;
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t led_strip_group_present(led_strip_group_t *group)
+{
+    CHECK(led_strip_group_flush(group));
+    for (size_t i = 0; i < group->count; i++)
+        next_buffer(group->strips[i]);
+
+    return ESP_OK;
+}
+
+esp_err_t led_strip_group_wait(led_strip_group_t *group, TickType_t timeout)
+{
+    CHECK_ARG(group && group->strips && group->count);
+
+    // All channels transmit simultaneously, so the whole group takes
+    // as long as the longest strip
+    for (size_t i = 0; i < group->count; i++)
+        CHECK(rmt_wait_tx_done(group->strips[i]->channel, timeout));
+
     return ESP_OK;
 }
@@ -48,6 +48,11 @@ extern "C" {
 #define LED_STRIP_BRIGHTNESS 1
 #endif
 
+/**
+ * Maximal number of pixel buffers
+ */
+#define LED_STRIP_MAX_BUFFERS 3
+
 /**
  * LED type
  */
@@ -68,16 +73,38 @@ typedef struct
 {
     led_strip_type_t type; ///< LED type
     bool is_rgbw;          ///< true for RGBW strips
+    bool encoded;          ///< Encode whole frame to RMT items in ::led_strip_flush() using
+                           ///< precomputed lookup tables instead of translating it in RMT ISR.
+                           ///< Takes additional 32 bytes of internal RAM per color channel of
+                           ///< each LED, e.g. 96 KB for 1000 RGB LEDs
 #ifdef LED_STRIP_BRIGHTNESS
     uint8_t brightness;    ///< Brightness 0..255, call ::led_strip_flush() after change.
+                           ///< In `encoded` mode brightness is applied when pixels are written,
+                           ///< so it affects only pixels set after the change.
                            ///< Supported only for ESP-IDF version >= 4.3
 #endif
+    const rgb_lut_t *lut;  ///< Optional gamma/color correction tables applied to colors in
+                           ///< ::led_strip_set_pixel() and friends, see ::rgb_lut_init(). May be NULL
     size_t length;         ///< Number of LEDs in strip
     gpio_num_t gpio;       ///< Data GPIO pin
     rmt_channel_t channel; ///< RMT channel
-    uint8_t *buf;
+    uint8_t buffers;       ///< Number of pixel buffers for ::led_strip_present(), 1..LED_STRIP_MAX_BUFFERS.
+                           ///< 0 means single buffer
+    uint8_t *buf;          ///< Current pixel buffer
+    uint8_t *frames;       ///< All pixel buffers, managed by driver
+    uint8_t back;          ///< Index of the current pixel buffer, managed by driver
+    rmt_item32_t *items;   ///< Encoded frame in `encoded` mode, managed by driver
 } led_strip_t;
 
+/**
+ * Group of LED strips flushed simultaneously
+ */
+typedef struct
+{
+    led_strip_t **strips; ///< Array of pointers to initialized strips, each on its own RMT channel
+    size_t count;         ///< Number of strips in group
+} led_strip_group_t;
+
 /**
  * @brief Setup library
  *
@@ -88,6 +115,10 @@ void led_strip_install();
 /**
  * @brief Initialize LED strip and allocate buffer memory
  *
+ * Pixel buffers take `length * buffers` * 3 (4 for RGBW) bytes. In `encoded`
+ * mode 8 RMT items (32 bytes) per color channel of each LED are allocated
+ * in addition, so long strips may need too much internal RAM for it.
+ *
  * @param strip Descriptor of LED strip
  * @return `ESP_OK` on success
  */
@@ -104,11 +135,29 @@ esp_err_t led_strip_free(led_strip_t *strip);
 /**
  * @brief Send strip buffer to LEDs
  *
+ * When `encoded` mode is enabled, strip buffer is encoded into RMT items
+ * before the function returns, so it can be modified for the next frame
+ * while the current one is being transmitted.
+ *
  * @param strip Descriptor of LED strip
  * @return `ESP_OK` on success
  */
 esp_err_t led_strip_flush(led_strip_t *strip);
 
+/**
+ * @brief Send strip buffer to LEDs and switch to the next buffer
+ *
+ * Same as ::led_strip_flush(), but when strip has more than one pixel
+ * buffer, the function then switches `buf` to the next buffer, which is not
+ * being transmitted. Application can render the next frame into it at once,
+ * while the presented frame is shifted out. New buffer is not cleared and
+ * contains one of the previous frames, so render complete frames.
+ *
+ * @param strip Descriptor of LED strip
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_present(led_strip_t *strip);
+
 /**
  * @brief Check if associated RMT channel is busy
  *
@@ -167,6 +216,90 @@ esp_err_t led_strip_set_pixels(led_strip_t *strip, size_t start, size_t len, rgb
  */
 esp_err_t led_strip_fill(led_strip_t *strip, size_t start, size_t len, rgb_t color);
 
+/**
+ * @brief Copy rectangular array of colors to LED strip buffer
+ *
+ * Rows are written one after another starting from LED `start`.
+ * In serpentine mode every odd row is written in reverse order, as in
+ * zigzag-wired LED matrices.
+ *
+ * A framebuffer can be copied with
+ * `led_strip_blit(strip, 0, fb->data, fb->width, fb->height, serpentine)`.
+ *
+ * This function does not actually change colors of the LEDs.
+ * Call ::led_strip_flush() to send buffer to the LEDs.
+ *
+ * @param strip Descriptor of LED strip
+ * @param start First LED index, 0-based
+ * @param data Pointer to `width * height` RGB colors, row by row
+ * @param width Number of colors in a row
+ * @param height Number of rows
+ * @param serpentine Reverse every odd row
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_blit(led_strip_t *strip, size_t start, const rgb_t *data, size_t width, size_t height,
+                         bool serpentine);
+
+/**
+ * @brief Initialize group of LED strips
+ *
+ * All strips in group must be initialized with ::led_strip_init() before.
+ * On targets supporting synchronous RMT transmission (ESP32-S2, ESP32-S3,
+ * ESP32-C3 etc.) RMT channels of the strips are added to the hardware
+ * synchronization group, so they start shifting out at the same moment.
+ * There is only one such group, so only one strip group may be initialized
+ * at a time on these targets, and its strips must be flushed only by
+ * ::led_strip_group_flush().
+ *
+ * @param group Strip group descriptor
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_group_init(led_strip_group_t *group);
+
+/**
+ * @brief Release group of LED strips
+ *
+ * Strips themselves are not freed.
+ *
+ * @param group Strip group descriptor
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_group_free(led_strip_group_t *group);
+
+/**
+ * @brief Send buffers of all strips in group to LEDs
+ *
+ * Waits until all strips finish previous transmission, then starts
+ * all of them together. Since strips are transmitted in parallel, a frame
+ * takes as long as the longest strip. If a strip fails to start on a
+ * target with synchronized RMT channels, strips already started are
+ * stopped and the frame is not sent.
+ *
+ * @param group Strip group descriptor
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_group_flush(led_strip_group_t *group);
+
+/**
+ * @brief Send buffers of all strips in group to LEDs and switch to the next buffers
+ *
+ * Same as ::led_strip_group_flush(), then switches every strip to its
+ * next pixel buffer as ::led_strip_present() does.
+ *
+ * @param group Strip group descriptor
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_group_present(led_strip_group_t *group);
+
+/**
+ * @brief Wait until all strips in group finish transmission
+ *
+ * @param group Strip group descriptor
+ * @param timeout Timeout in RTOS ticks for every strip
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_group_wait(led_strip_group_t *group, TickType_t timeout);
+
 #ifdef __cplusplus
 }
 #endif
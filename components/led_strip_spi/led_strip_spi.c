@@ -72,6 +72,14 @@ fail:
 }
 
 #if HELPER_TARGET_IS_ESP32
+static void IRAM_ATTR post_cb(spi_transaction_t *t)
+{
+    led_strip_spi_t *strip = (led_strip_spi_t *)t->user;
+
+    if (strip && strip->done_cb)
+        strip->done_cb(strip->done_ctx);
+}
+
 static esp_err_t led_strip_spi_init_esp32(led_strip_spi_t *strip)
 {
     CHECK_ARG(strip);
@@ -99,6 +107,7 @@ static esp_err_t led_strip_spi_init_esp32(led_strip_spi_t *strip)
         .command_bits = 0,
         .address_bits = 0,
         .dummy_bits = 0,
+        .post_cb = post_cb,
     };
 
     if (xSemaphoreTake(mutex, MUTEX_TIMEOUT) != pdTRUE) {
@@ -107,27 +116,33 @@ static esp_err_t led_strip_spi_init_esp32(led_strip_spi_t *strip)
         goto fail_without_give;
     }
 
-    strip->buf = heap_caps_malloc(LED_STRIP_SPI_BUFFER_SIZE(strip->length), MALLOC_CAP_DMA | MALLOC_CAP_32BIT);
-    if (strip->buf == NULL) {
-        ESP_LOGE(TAG, "heap_caps_malloc()");
-        err = ESP_ERR_NO_MEM;
-        goto fail;
-    }
-    memset(strip->buf, 0, LED_STRIP_SPI_BUFFER_SIZE(strip->length));
-
-    /* XXX length is in bit */
-    strip->transaction.length = LED_STRIP_SPI_BUFFER_SIZE(strip->length) * 8;
+    strip->bufs[0] = strip->bufs[1] = NULL;
+    strip->busy = false;
+    for (int i = 0; i < (strip->double_buffer ? 2 : 1); i++) {
+        strip->buf = strip->bufs[i] = heap_caps_malloc(LED_STRIP_SPI_BUFFER_SIZE(strip->length), MALLOC_CAP_DMA | MALLOC_CAP_32BIT);
+        if (strip->buf == NULL) {
+            ESP_LOGE(TAG, "heap_caps_malloc()");
+            err = ESP_ERR_NO_MEM;
+            goto fail;
+        }
+        memset(strip->buf, 0, LED_STRIP_SPI_BUFFER_SIZE(strip->length));
 
-    /* type-specific initialization  */
+        /* type-specific initialization  */
 #if CONFIG_LED_STRIP_SPI_USING_SK9822
-    err = led_strip_spi_sk9822_buf_init(strip);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "led_strip_spi_sk9822_buf_init(): %s", esp_err_to_name(err));
-        goto fail;
-    }
+        err = led_strip_spi_sk9822_buf_init(strip);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "led_strip_spi_sk9822_buf_init(): %s", esp_err_to_name(err));
+            goto fail;
+        }
 #endif
+    }
+    strip->buf = strip->bufs[0];
     ESP_LOGD(TAG, "SPI buffer initialized");
 
+    /* XXX length is in bit */
+    strip->transaction.length = LED_STRIP_SPI_BUFFER_SIZE(strip->length) * 8;
+    strip->transaction.user = strip;
+
     err = spi_bus_initialize(strip->host_device, &bus_config, strip->dma_chan);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "spi_bus_initialize(): %s", esp_err_to_name(err));
@@ -228,34 +243,70 @@ esp_err_t led_strip_spi_free(led_strip_spi_t *strip)
 {
     CHECK_ARG(strip);
 
+#if HELPER_TARGET_IS_ESP32
+    CHECK(led_strip_spi_wait(strip, portMAX_DELAY));
+    free(strip->bufs[0]);
+    free(strip->bufs[1]);
+    strip->bufs[0] = strip->bufs[1] = NULL;
+#else
     free(strip->buf);
+#endif
+    strip->buf = NULL;
     return ESP_OK;
 }
 
 #if HELPER_TARGET_IS_ESP32
-static esp_err_t led_strip_spi_flush_esp32(led_strip_spi_t *strip)
+static esp_err_t wait_esp32(led_strip_spi_t *strip, TickType_t timeout)
 {
-    esp_err_t err = ESP_FAIL;
+    esp_err_t err;
     spi_transaction_t* t;
 
-    CHECK_ARG(strip);
-    if (!strip->transaction.tx_buffer) {
-        strip->transaction.tx_buffer = strip->buf;
+    if (!strip->busy)
+        return ESP_OK;
+
+    err = spi_device_get_trans_result(strip->device_handle, &t, timeout);
+    if (err == ESP_OK) {
+        strip->busy = false;
+    } else if (err != ESP_ERR_TIMEOUT) {
+        ESP_LOGE(TAG, "spi_device_get_trans_result(): %s", esp_err_to_name(err));
     }
+    return err;
+}
+
+static esp_err_t start_esp32(led_strip_spi_t *strip)
+{
+    esp_err_t err;
+
+    /* only one transaction can be in flight: it is shared between frames */
+    CHECK(wait_esp32(strip, portMAX_DELAY));
+
     strip->transaction.tx_buffer = strip->buf;
     err = spi_device_queue_trans(strip->device_handle, &strip->transaction, portMAX_DELAY);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "spi_device_queue_trans(): %s", esp_err_to_name(err));
-        goto fail;
+        return err;
     }
-    err = spi_device_get_trans_result(strip->device_handle, &t, portMAX_DELAY);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "spi_device_get_trans_result(): %s", esp_err_to_name(err));
-        goto fail;
-    }
-    err = ESP_OK;
-fail:
-    return err;
+    strip->busy = true;
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_flush_esp32(led_strip_spi_t *strip)
+{
+    CHECK_ARG(strip && strip->buf);
+
+    CHECK(start_esp32(strip));
+    return wait_esp32(strip, portMAX_DELAY);
+}
+
+static esp_err_t led_strip_spi_flush_async_esp32(led_strip_spi_t *strip)
+{
+    CHECK_ARG(strip && strip->buf);
+
+    CHECK(start_esp32(strip));
+    /* switch to the buffer which is not being sent */
+    if (strip->bufs[1])
+        strip->buf = strip->buf == strip->bufs[0] ? strip->bufs[1] : strip->bufs[0];
+    return ESP_OK;
 }
 #endif
 
@@ -321,6 +372,34 @@ esp_err_t led_strip_spi_flush(led_strip_spi_t*strip)
 #endif
 }
 
+esp_err_t led_strip_spi_flush_async(led_strip_spi_t *strip)
+{
+#if HELPER_TARGET_IS_ESP32
+    return led_strip_spi_flush_async_esp32(strip);
+#elif HELPER_TARGET_IS_ESP8266
+    /* spi_trans() is synchronous, there is nothing to wait for later */
+    return led_strip_spi_flush_esp8266(strip);
+#else
+#error "Unknown target"
+#endif
+}
+
+esp_err_t led_strip_spi_wait(led_strip_spi_t *strip, TickType_t timeout)
+{
+    CHECK_ARG(strip);
+
+#if HELPER_TARGET_IS_ESP32
+    return wait_esp32(strip, timeout);
+#else
+    return ESP_OK;
+#endif
+}
+
+bool led_strip_spi_busy(led_strip_spi_t *strip)
+{
+    return led_strip_spi_wait(strip, 0) == ESP_ERR_TIMEOUT;
+}
+
 esp_err_t led_strip_spi_set_pixel(led_strip_spi_t *strip, const int index, const rgb_t color)
 {
     return led_strip_spi_set_pixel_brightness(strip, index, color, LED_STRIP_SPI_MAX_BRIGHTNESS);
@@ -346,25 +425,32 @@ esp_err_t led_strip_spi_set_pixel_brightness(led_strip_spi_t *strip, const int i
 
 esp_err_t led_strip_spi_set_pixels_brightness(led_strip_spi_t*strip, const int start, size_t len, const rgb_t data, const uint8_t brightness)
 {
-    esp_err_t err = ESP_FAIL;
-
-    for (int i = 0; i < len; i++) {
-        err = led_strip_spi_set_pixel_brightness(strip, start + i, data, brightness);
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "led_strip_spi_set_pixel(): %s", esp_err_to_name(err));
-            goto fail;
-        }
-    }
-fail:
-    return err;
+    return led_strip_spi_fill_brightness(strip, start, len, data, brightness);
 }
 
 esp_err_t led_strip_spi_fill_brightness(led_strip_spi_t*strip, size_t start, size_t len, rgb_t color, const uint8_t brightness)
 {
     CHECK_ARG(strip && len && start + len <= strip->length);
 
-    for (size_t i = start; i < len; i++) {
-        CHECK(led_strip_spi_set_pixel_brightness(strip, i, color, brightness));
-    }
-    return ESP_OK;
+#if CONFIG_LED_STRIP_SPI_USING_SK9822
+    return led_strip_spi_set_pixels_sk9822(strip, start, len, &color, 0, brightness);
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t led_strip_spi_set_pixel_data(led_strip_spi_t *strip, size_t start, size_t len, const rgb_t *data)
+{
+    return led_strip_spi_set_pixel_data_brightness(strip, start, len, data, LED_STRIP_SPI_MAX_BRIGHTNESS);
+}
+
+esp_err_t led_strip_spi_set_pixel_data_brightness(led_strip_spi_t *strip, size_t start, size_t len, const rgb_t *data, const uint8_t brightness)
+{
+    CHECK_ARG(strip && data && len && start + len <= strip->length);
+
+#if CONFIG_LED_STRIP_SPI_USING_SK9822
+    return led_strip_spi_set_pixels_sk9822(strip, start, len, data, 1, brightness);
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
 }
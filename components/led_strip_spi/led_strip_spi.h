@@ -35,6 +35,7 @@
 
 #include <driver/gpio.h>
 #include <esp_err.h>
+#include <freertos/FreeRTOS.h>
 #include <color.h>
 #include <esp_idf_lib_helpers.h>
 
@@ -104,6 +105,43 @@ esp_err_t led_strip_spi_free(led_strip_spi_t *strip);
  */
 esp_err_t led_strip_spi_flush(led_strip_spi_t*strip);
 
+/**
+ * @brief Start sending strip buffer to LEDs and return immediately
+ *
+ * On ESP32-family the buffer is sent by SPI DMA in background. If
+ * `strip->double_buffer` is set, `strip->buf` is switched to the second
+ * buffer, so the next frame can be rendered while the current one is being
+ * sent. Otherwise buffer must not be modified until the transfer is done.
+ * Contents of the switched-to buffer are left from the frame before last.
+ *
+ * Completion can be detected by `strip->done_cb`, ::led_strip_spi_busy() or
+ * ::led_strip_spi_wait(). Transfer started earlier is waited for before the
+ * new one is queued.
+ *
+ * On ESP8266 this function is synchronous and same as ::led_strip_spi_flush().
+ *
+ * @param strip Descriptor of LED strip
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_spi_flush_async(led_strip_spi_t *strip);
+
+/**
+ * @brief Check if transfer started by ::led_strip_spi_flush_async() is in progress
+ *
+ * @param strip Descriptor of LED strip
+ * @return true if transfer is in progress
+ */
+bool led_strip_spi_busy(led_strip_spi_t *strip);
+
+/**
+ * @brief Wait until transfer started by ::led_strip_spi_flush_async() is done
+ *
+ * @param strip Descriptor of LED strip
+ * @param timeout Timeout in ticks
+ * @return `ESP_OK` on success, `ESP_ERR_TIMEOUT` if transfer is still in progress
+ */
+esp_err_t led_strip_spi_wait(led_strip_spi_t *strip, TickType_t timeout);
+
 /**
  * @brief Set color of single LED in strip.
  *
@@ -188,6 +226,38 @@ esp_err_t led_strip_spi_fill(led_strip_spi_t*strip, size_t start, size_t len, rg
  * @return `ESP_OK` on success
  */
 esp_err_t led_strip_spi_fill_brightness(led_strip_spi_t*strip, size_t start, size_t len, rgb_t color, const uint8_t brightness);
+
+/**
+ * @brief Copy array of colors to consecutive LEDs.
+ *
+ * This function does not actually change colors of the LEDs.
+ * Call ::led_strip_spi_flush() to send buffer to the LEDs.
+ *
+ * A framebuffer can be copied with
+ * `led_strip_spi_set_pixel_data(strip, 0, fb->width * fb->height, fb->data)`.
+ *
+ * @param strip Descriptor of LED strip
+ * @param start First LED index, 0-based
+ * @param len Number of LEDs
+ * @param data Pointer to array of `len` RGB colors
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_spi_set_pixel_data(led_strip_spi_t *strip, size_t start, size_t len, const rgb_t *data);
+
+/**
+ * @brief Copy array of colors to consecutive LEDs.
+ *
+ * This function does not actually change colors of the LEDs.
+ * Call ::led_strip_spi_flush() to send buffer to the LEDs.
+ *
+ * @param strip Descriptor of LED strip
+ * @param start First LED index, 0-based
+ * @param len Number of LEDs
+ * @param data Pointer to array of `len` RGB colors
+ * @param brightness Brightness of the LEDs, [0:100].
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_spi_set_pixel_data_brightness(led_strip_spi_t *strip, size_t start, size_t len, const rgb_t *data, const uint8_t brightness);
 #ifdef __cplusplus
 }
 #endif
@@ -49,6 +49,13 @@
 #define LED_STRIP_SPI_DEFAULT_SCLK_IO_NUM   (14) ///< GPIO pin number of `LED_STRIP_SPI_DEFAULT_HOST_DEVICE`'s SCLK (default is 14 for ESP32, 6 for ESP32C3)
 #endif
 
+/**
+ * Callback called when asynchronous transfer is done.
+ *
+ * Called from SPI interrupt, must be placed in IRAM and must not block.
+ */
+typedef void (*led_strip_spi_done_cb_t)(void *ctx);
+
 /**
  * LED strip descriptor for ESP32-family.
  */
@@ -65,6 +72,11 @@ typedef struct
     spi_device_handle_t device_handle;  ///< Device handle assigned by the driver. The caller must provdie this.
     int dma_chan;                       ///< DMA channed to use. Either 1 or 2.
     spi_transaction_t transaction;      ///< SPI transaction used internally by the driver.
+    bool double_buffer;                 ///< Allocate second DMA buffer to render next frame while current one is sent, see ::led_strip_spi_flush_async()
+    led_strip_spi_done_cb_t done_cb;    ///< Optional callback, called from ISR when asynchronous transfer is done
+    void *done_ctx;                     ///< Argument passed to `done_cb`
+    void *bufs[2];                      ///< DMA buffers, used internally by the driver.
+    bool busy;                          ///< Transfer is in progress, used internally by the driver.
 } led_strip_spi_esp32_t;
 
 /**
@@ -88,7 +100,9 @@ typedef struct
  * `clock_speed_hz`: 1000000,
  * `queue_size`: 1,
  * `device_handle`: `NULL`,
- * `dma_chan`: 1
+ * `dma_chan`: 1,
+ * `double_buffer`: `false`,
+ * `done_cb`: `NULL`
  */
 #define LED_STRIP_SPI_DEFAULT_ESP32() \
 { \
@@ -102,6 +116,8 @@ typedef struct
     .queue_size = 1,                                  \
     .device_handle = NULL,                            \
     .dma_chan = LED_STRIP_SPI_DEFAULT_DMA_CHAN,       \
+    .double_buffer = false,                           \
+    .done_cb = NULL,                                  \
 }
 
 /** @} */
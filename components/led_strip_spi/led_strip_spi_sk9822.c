@@ -26,9 +26,8 @@
 #include "led_strip_spi.h"
 #include "led_strip_spi_sk9822.h"
 
-esp_err_t led_strip_spi_set_pixel_sk9822(led_strip_spi_t *strip, size_t num, rgb_t color, uint8_t brightness)
+static inline uint8_t cook_brightness(uint8_t brightness)
 {
-    int index = (num + 1) * 4;
     uint8_t cooked_brightness = 0;
     /* Don't divided the range equal instead, the bottom 10 % is actually 0 brightness 
        then every 3 percent after that increase the brightness level by 1 */
@@ -37,11 +36,26 @@ esp_err_t led_strip_spi_set_pixel_sk9822(led_strip_spi_t *strip, size_t num, rgb
     } else if (brightness > 7){
         cooked_brightness = (brightness - 7) / 3;
     }
-    ((uint8_t *)strip->buf)[index    ] = LED_STRIP_SPI_FRAME_SK9822_LED_MSB3 | 
-                                         (cooked_brightness & ((1 << LED_STRIP_SPI_FRAME_SK9822_LED_BRIGHTNESS_BITS) - 1));
-    ((uint8_t *)strip->buf)[index + 1] = color.b;
-    ((uint8_t *)strip->buf)[index + 2] = color.g;
-    ((uint8_t *)strip->buf)[index + 3] = color.r;
+    return LED_STRIP_SPI_FRAME_SK9822_LED_MSB3 |
+           (cooked_brightness & ((1 << LED_STRIP_SPI_FRAME_SK9822_LED_BRIGHTNESS_BITS) - 1));
+}
+
+esp_err_t led_strip_spi_set_pixel_sk9822(led_strip_spi_t *strip, size_t num, rgb_t color, uint8_t brightness)
+{
+    return led_strip_spi_set_pixels_sk9822(strip, num, 1, &color, 0, brightness);
+}
+
+esp_err_t led_strip_spi_set_pixels_sk9822(led_strip_spi_t *strip, size_t start, size_t len, const rgb_t *data, int step, uint8_t brightness)
+{
+    uint8_t *dst = (uint8_t *)strip->buf + (start + 1) * LED_STRIP_SPI_FRAME_SK9822_LED_SIZE;
+    uint8_t header = cook_brightness(brightness);
+
+    for (; len; len--, data += step, dst += LED_STRIP_SPI_FRAME_SK9822_LED_SIZE) {
+        dst[0] = header;
+        dst[1] = data->b;
+        dst[2] = data->g;
+        dst[3] = data->r;
+    }
     return ESP_OK;
 }
 
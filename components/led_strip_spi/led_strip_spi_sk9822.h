@@ -87,6 +87,22 @@ esp_err_t led_strip_spi_sk9822_buf_init(led_strip_spi_t *strip);
  */
 esp_err_t led_strip_spi_set_pixel_sk9822(led_strip_spi_t *strip, size_t num, rgb_t color, uint8_t brightness);
 
+/**
+ * @brief Set colors of multiple pixels of SK9822 strip.
+ *
+ * Brightness is converted once for the whole run. Bounds are not checked.
+ *
+ * @param[in] strip LED strip descriptor.
+ * @param[in] start Index of the first LED pixel (zero-based).
+ * @param[in] len Number of pixels.
+ * @param[in] data Source colors.
+ * @param[in] step Source pointer increment per pixel: 1 to copy an array,
+ *                 0 to fill with `*data`.
+ * @param[in] brightness The brightness to set, [0:100].
+ * @return `ESP_OK` on success.
+ */
+esp_err_t led_strip_spi_set_pixels_sk9822(led_strip_spi_t *strip, size_t start, size_t len, const rgb_t *data, int step, uint8_t brightness);
+
 #ifdef __cplusplus
 }
 #endif
@@ -47,6 +47,7 @@
 #include "mpu6050.h"
 #include "mpu6050_regs.h"
 #include <math.h>
+#include <string.h>
 #include <esp_log.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
@@ -211,6 +212,18 @@ esp_err_t mpu6050_init_desc(mpu6050_dev_t *dev, uint8_t addr, i2c_port_t port, g
     dev->i2c_dev.cfg.master.clk_speed = I2C_FREQ_HZ;
 #endif
 
+    uint8_t reg = MPU6050_REGISTER_ACCEL_XOUT_H;
+    i2c_dev_transfer_t xfer = {
+        .dev = &dev->i2c_dev,
+        .type = I2C_DEV_READ,
+        .reg = &reg,
+        .reg_size = 1,
+        .data = dev->motion_buf,
+        .size = sizeof(dev->motion_buf)
+    };
+    memset(&dev->motion_cmd, 0, sizeof(dev->motion_cmd));
+    CHECK(i2c_dev_cmd_prepare(&dev->motion_cmd, &xfer));
+
     return i2c_dev_create_mutex(&dev->i2c_dev);
 }
 
@@ -218,6 +231,8 @@ esp_err_t mpu6050_free_desc(mpu6050_dev_t *dev)
 {
     CHECK_ARG(dev);
 
+    CHECK(i2c_dev_cmd_free(&dev->motion_cmd));
+
     return i2c_dev_delete_mutex(&dev->i2c_dev);
 }
 
@@ -943,8 +958,20 @@ esp_err_t mpu6050_get_rotation_axis(mpu6050_dev_t *dev, mpu6050_axis_t axis, flo
 
 esp_err_t mpu6050_get_motion(mpu6050_dev_t *dev, mpu6050_acceleration_t *accel, mpu6050_rotation_t *gyro)
 {
-    CHECK(mpu6050_get_acceleration(dev, accel));
-    CHECK(mpu6050_get_rotation(dev, gyro));
+    CHECK_ARG(dev && accel && gyro);
+
+    // ACCEL_XOUT_H..GYRO_ZOUT_L in one burst, motion_buf[3] is temperature
+    I2C_DEV_TAKE_MUTEX(&dev->i2c_dev);
+    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_cmd_exec(&dev->motion_cmd));
+    // decode before giving the mutex, buffer is shared by all callers
+    accel->x = get_accel_value(dev, shuffle(dev->motion_buf[0]));
+    accel->y = get_accel_value(dev, shuffle(dev->motion_buf[1]));
+    accel->z = get_accel_value(dev, shuffle(dev->motion_buf[2]));
+    gyro->x = get_gyro_value(dev, shuffle(dev->motion_buf[4]));
+    gyro->y = get_gyro_value(dev, shuffle(dev->motion_buf[5]));
+    gyro->z = get_gyro_value(dev, shuffle(dev->motion_buf[6]));
+    I2C_DEV_GIVE_MUTEX(&dev->i2c_dev);
+
     return ESP_OK;
 }
 
@@ -291,6 +291,8 @@ typedef struct {
         mpu6050_gyro_range_t gyro;
         mpu6050_accel_range_t accel;
     } ranges;
+    i2c_dev_cmd_t motion_cmd; //!< Prepared burst read of accelerometer, temperature and gyroscope registers
+    uint16_t motion_buf[7];   //!< Raw data of motion_cmd
 } mpu6050_dev_t;
 
 /**
@@ -336,13 +336,9 @@ uint16_t inoise16_1d(uint32_t x)
     return ((uint32_t)((int32_t)inoise16_1d_raw(x) + 17308L)) << 1;
 }
 
-int8_t inoise8_3d_raw(uint16_t x, uint16_t y, uint16_t z)
+// Hashes of the 8 corners of the lattice cube, in order of use by eval8_3d()
+ALWAYS_INLINE void hash8_3d(uint8_t X, uint8_t Y, uint8_t Z, uint8_t *h)
 {
-    // Find the unit cube containing the point
-    uint8_t X = x >> 8;
-    uint8_t Y = y >> 8;
-    uint8_t Z = z >> 8;
-
     // Hash cube corner coordinates
     uint8_t A  = P(X) + Y;
     uint8_t AA = P(A) + Z;
@@ -351,25 +347,30 @@ int8_t inoise8_3d_raw(uint16_t x, uint16_t y, uint16_t z)
     uint8_t BA = P(B) + Z;
     uint8_t BB = P(B + 1) +Z;
 
-    // Get the relative position of the point in the cube
-    uint8_t u = x;
-    uint8_t v = y;
-    uint8_t w = z;
+    h[0] = P(AA);
+    h[1] = P(BA);
+    h[2] = P(AB);
+    h[3] = P(BB);
+    h[4] = P(AA + 1);
+    h[5] = P(BA + 1);
+    h[6] = P(AB + 1);
+    h[7] = P(BB + 1);
+}
 
+// fx is the relative position of the point in the cube along X, v and w are
+// eased relative positions along Y and Z, yy and zz their signed versions
+ALWAYS_INLINE int8_t eval8_3d(const uint8_t *h, uint8_t fx, int8_t yy, int8_t zz, uint8_t v, uint8_t w)
+{
     // Get a signed version of the above for the grad function
-    int8_t xx = ((uint8_t)x >> 1) & 0x7F;
-    int8_t yy = ((uint8_t)y >> 1) & 0x7F;
-    int8_t zz = ((uint8_t)z >> 1) & 0x7F;
+    int8_t xx = (fx >> 1) & 0x7F;
     uint8_t N = 0x80;
 
-    u = ease8InOutQuad(u);
-    v = ease8InOutQuad(v);
-    w = ease8InOutQuad(w);
+    uint8_t u = ease8InOutQuad(fx);
 
-    int8_t X1 = lerp7by8(grad8_3d(P(AA), xx, yy, zz), grad8_3d(P(BA), xx - N, yy, zz), u);
-    int8_t X2 = lerp7by8(grad8_3d(P(AB), xx, yy - N, zz), grad8_3d(P(BB), xx - N, yy - N, zz), u);
-    int8_t X3 = lerp7by8(grad8_3d(P(AA + 1), xx, yy, zz - N), grad8_3d(P(BA + 1), xx - N, yy, zz - N), u);
-    int8_t X4 = lerp7by8(grad8_3d(P(AB + 1), xx, yy - N, zz - N), grad8_3d(P(BB + 1), xx - N, yy - N, zz - N), u);
+    int8_t X1 = lerp7by8(grad8_3d(h[0], xx, yy, zz), grad8_3d(h[1], xx - N, yy, zz), u);
+    int8_t X2 = lerp7by8(grad8_3d(h[2], xx, yy - N, zz), grad8_3d(h[3], xx - N, yy - N, zz), u);
+    int8_t X3 = lerp7by8(grad8_3d(h[4], xx, yy, zz - N), grad8_3d(h[5], xx - N, yy, zz - N), u);
+    int8_t X4 = lerp7by8(grad8_3d(h[6], xx, yy - N, zz - N), grad8_3d(h[7], xx - N, yy - N, zz - N), u);
 
     int8_t Y1 = lerp7by8(X1, X2, v);
     int8_t Y2 = lerp7by8(X3, X4, v);
@@ -377,19 +378,8 @@ int8_t inoise8_3d_raw(uint16_t x, uint16_t y, uint16_t z)
     return lerp7by8(Y1, Y2, w);
 }
 
-uint8_t inoise8_3d(uint16_t x, uint16_t y, uint16_t z)
+ALWAYS_INLINE void hash8_2d(uint8_t X, uint8_t Y, uint8_t *h)
 {
-    int8_t n = inoise8_3d_raw(x, y, z);  // -64..+64
-    n += 64;                             //   0..128
-    return qadd8(n, n);                  //   0..255
-}
-
-int8_t inoise8_2d_raw(uint16_t x, uint16_t y)
-{
-    // Find the unit cube containing the point
-    uint8_t X = x >> 8;
-    uint8_t Y = y >> 8;
-
     // Hash cube corner coordinates
     uint8_t A  = P(X)+Y;
     uint8_t AA = P(A);
@@ -398,29 +388,61 @@ int8_t inoise8_2d_raw(uint16_t x, uint16_t y)
     uint8_t BA = P(B);
     uint8_t BB = P(B + 1);
 
-    // Get the relative position of the point in the cube
-    uint8_t u = x;
-    uint8_t v = y;
+    h[0] = P(AA);
+    h[1] = P(BA);
+    h[2] = P(AB);
+    h[3] = P(BB);
+}
 
+ALWAYS_INLINE int8_t eval8_2d(const uint8_t *h, uint8_t fx, int8_t yy, uint8_t v)
+{
     // Get a signed version of the above for the grad function
-    int8_t xx = ((uint8_t)x >> 1) & 0x7F;
-    int8_t yy = ((uint8_t)y >> 1) & 0x7F;
+    int8_t xx = (fx >> 1) & 0x7F;
     uint8_t N = 0x80;
 
-    u = ease8InOutQuad(u);
-    v = ease8InOutQuad(v);
+    uint8_t u = ease8InOutQuad(fx);
 
-    int8_t X1 = lerp7by8(grad8_2d(P(AA), xx, yy), grad8_2d(P(BA), xx - N, yy), u);
-    int8_t X2 = lerp7by8(grad8_2d(P(AB), xx, yy - N), grad8_2d(P(BB), xx - N, yy - N), u);
+    int8_t X1 = lerp7by8(grad8_2d(h[0], xx, yy), grad8_2d(h[1], xx - N, yy), u);
+    int8_t X2 = lerp7by8(grad8_2d(h[2], xx, yy - N), grad8_2d(h[3], xx - N, yy - N), u);
 
     return lerp7by8(X1, X2, v);
 }
 
+ALWAYS_INLINE uint8_t scale_noise8(int8_t n)
+{
+    n += 64;             //   0..128
+    return qadd8(n, n);  //   0..255
+}
+
+int8_t inoise8_3d_raw(uint16_t x, uint16_t y, uint16_t z)
+{
+    uint8_t h[8];
+
+    // Find the unit cube containing the point
+    hash8_3d(x >> 8, y >> 8, z >> 8, h);
+
+    return eval8_3d(h, x, ((uint8_t)y >> 1) & 0x7F, ((uint8_t)z >> 1) & 0x7F,
+                    ease8InOutQuad(y), ease8InOutQuad(z));
+}
+
+uint8_t inoise8_3d(uint16_t x, uint16_t y, uint16_t z)
+{
+    return scale_noise8(inoise8_3d_raw(x, y, z));  // -64..+64 -> 0..255
+}
+
+int8_t inoise8_2d_raw(uint16_t x, uint16_t y)
+{
+    uint8_t h[4];
+
+    // Find the unit cube containing the point
+    hash8_2d(x >> 8, y >> 8, h);
+
+    return eval8_2d(h, x, ((uint8_t)y >> 1) & 0x7F, ease8InOutQuad(y));
+}
+
 uint8_t inoise8_2d(uint16_t x, uint16_t y)
 {
-    int8_t n = inoise8_2d_raw(x, y);  // -64..+64
-    n += 64;                          //   0..128
-    return qadd8(n, n);               //   0..255
+    return scale_noise8(inoise8_2d_raw(x, y));  // -64..+64 -> 0..255
 }
 
 // output range = -64 .. +64
@@ -489,3 +511,83 @@ void fill_raw_noise16into8(uint8_t *pData, uint8_t num_points, uint8_t octaves,
         scx <<= 1;
     }
 }
+
+// Rows of noise field: lattice hashes are computed once per cell and
+// everything depending on Y and Z once per row
+
+ALWAYS_INLINE void put_noise8(uint8_t *dst, int8_t raw, uint8_t octave)
+{
+    uint8_t n = scale_noise8(raw) >> octave;
+    *dst = octave ? qadd8(*dst, n) : n;
+}
+
+static void noise8_2d_row(uint8_t *row, size_t width, uint8_t octave, uint16_t x, uint16_t scale_x, uint16_t y)
+{
+    uint8_t h[4] = { 0 };
+    int cell = -1;
+    uint8_t Y = y >> 8;
+    int8_t yy = ((uint8_t)y >> 1) & 0x7F;
+    uint8_t v = ease8InOutQuad(y);
+
+    for (size_t i = 0; i < width; i++, x += scale_x)
+    {
+        if ((x >> 8) != cell)
+        {
+            cell = x >> 8;
+            hash8_2d(cell, Y, h);
+        }
+        put_noise8(row + i, eval8_2d(h, x, yy, v), octave);
+    }
+}
+
+static void noise8_3d_row(uint8_t *row, size_t width, uint8_t octave, uint16_t x, uint16_t scale_x, uint16_t y, uint16_t z)
+{
+    uint8_t h[8] = { 0 };
+    int cell = -1;
+    uint8_t Y = y >> 8;
+    uint8_t Z = z >> 8;
+    int8_t yy = ((uint8_t)y >> 1) & 0x7F;
+    int8_t zz = ((uint8_t)z >> 1) & 0x7F;
+    uint8_t v = ease8InOutQuad(y);
+    uint8_t w = ease8InOutQuad(z);
+
+    for (size_t i = 0; i < width; i++, x += scale_x)
+    {
+        if ((x >> 8) != cell)
+        {
+            cell = x >> 8;
+            hash8_3d(cell, Y, Z, h);
+        }
+        put_noise8(row + i, eval8_3d(h, x, yy, zz, v, w), octave);
+    }
+}
+
+void fill_noise8_2d(uint8_t *data, size_t width, size_t height, size_t stride, uint8_t octaves,
+                    uint16_t x, uint16_t y, uint16_t scale_x, uint16_t scale_y)
+{
+    if (!data)
+        return;
+
+    for (uint8_t o = 0; o < octaves; o++, x <<= 1, y <<= 1, scale_x <<= 1, scale_y <<= 1)
+    {
+        uint8_t *row = data;
+        uint16_t yy = y;
+        for (size_t r = 0; r < height; r++, row += stride, yy += scale_y)
+            noise8_2d_row(row, width, o, x, scale_x, yy);
+    }
+}
+
+void fill_noise8_3d(uint8_t *data, size_t width, size_t height, size_t stride, uint8_t octaves,
+                    uint16_t x, uint16_t y, uint16_t z, uint16_t scale_x, uint16_t scale_y)
+{
+    if (!data)
+        return;
+
+    for (uint8_t o = 0; o < octaves; o++, x <<= 1, y <<= 1, scale_x <<= 1, scale_y <<= 1)
+    {
+        uint8_t *row = data;
+        uint16_t yy = y;
+        for (size_t r = 0; r < height; r++, row += stride, yy += scale_y)
+            noise8_3d_row(row, width, o, x, scale_x, yy, z);
+    }
+}
@@ -24,6 +24,7 @@
 #ifndef __NOISE_H__
 #define __NOISE_H__
 
+#include <stddef.h>
 #include <lib8tion.h>
 
 ///@file noise.h
@@ -91,6 +92,30 @@ int8_t inoise8_1d_raw(uint16_t x);
 void fill_raw_noise8(uint8_t *pData, uint8_t num_points, uint8_t octaves, uint16_t x, int scale, uint16_t time);
 void fill_raw_noise16into8(uint8_t *pData, uint8_t num_points, uint8_t octaves, uint32_t x, int scale, uint32_t time);
 ///@}
+
+///@name field fill functions
+///@{
+/// Fill a 2d field of 8-bit values, e.g. palette indices for a matrix, with scaled
+/// 8-bit noise row by row. Values are the same as of inoise8_2d()/inoise8_3d() at
+/// (x + col * scalex, y + row * scaley[, z]), but lattice hashes and fade curves are
+/// shared between neighbouring points, so this is much faster than calling point
+/// functions for every pixel. First octave overwrites the field, every next octave
+/// has doubled coordinates and scales, half amplitude and is added with saturation.
+///@param data the array of data to write into
+///@param width the number of points in a row
+///@param height the number of rows
+///@param stride the distance between rows in the array, usually equal to width
+///@param octaves the number of octaves to use for noise, at least 1
+///@param x the x position in the noise field
+///@param y the y position in the noise field
+///@param z the z position (time) in the noise field for 3d functions
+///@param scalex the scale (distance) between x points
+///@param scaley the scale (distance) between y points
+void fill_noise8_2d(uint8_t *data, size_t width, size_t height, size_t stride, uint8_t octaves,
+                    uint16_t x, uint16_t y, uint16_t scalex, uint16_t scaley);
+void fill_noise8_3d(uint8_t *data, size_t width, size_t height, size_t stride, uint8_t octaves,
+                    uint16_t x, uint16_t y, uint16_t z, uint16_t scalex, uint16_t scaley);
+///@}
 ///@}
 
 #ifdef __cplusplus
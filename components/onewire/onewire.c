@@ -56,6 +56,70 @@
 #include <esp_idf_lib_helpers.h>
 #include "onewire.h"
 
+#if CONFIG_ONEWIRE_RMT
+#include <stdlib.h>
+#include <freertos/ringbuf.h>
+#include <esp_idf_version.h>
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 3, 0)
+#include <esp_rom_gpio.h>
+#include <soc/rmt_periph.h>
+#include <soc/soc_caps.h>
+#define RMT_TX_SIGNAL(ch) (rmt_periph_signals.groups[0].channels[ch].tx_sig)
+#define rmt_connect_pin(ch, mode, pin) rmt_set_gpio(ch, mode, pin, false)
+#define connect_out_signal(pin, sig) esp_rom_gpio_connect_out_signal(pin, sig, false, false)
+#else
+#include <rom/gpio.h>
+#include <soc/gpio_sig_map.h>
+#define RMT_TX_SIGNAL(ch) (RMT_SIG_OUT0_IDX + (ch))
+#define rmt_connect_pin(ch, mode, pin) rmt_set_pin(ch, mode, pin)
+#define connect_out_signal(pin, sig) gpio_matrix_out(pin, sig, false, false)
+#endif
+
+#if defined(SOC_RMT_MEM_WORDS_PER_CHANNEL)
+#define RMT_MEM_ITEMS SOC_RMT_MEM_WORDS_PER_CHANNEL
+#elif defined(SOC_RMT_CHANNEL_MEM_WORDS)
+#define RMT_MEM_ITEMS SOC_RMT_CHANNEL_MEM_WORDS
+#else
+#define RMT_MEM_ITEMS 64
+#endif
+
+#ifndef RMT_DEFAULT_CONFIG_TX
+#define RMT_DEFAULT_CONFIG_TX(gpio, channel_id)      \
+    {                                                \
+        .rmt_mode = RMT_MODE_TX,                     \
+        .channel = channel_id,                       \
+        .gpio_num = gpio,                            \
+        .clk_div = 80,                               \
+        .mem_block_num = 1,                          \
+        .tx_config = {                               \
+            .carrier_freq_hz = 38000,                \
+            .carrier_level = RMT_CARRIER_LEVEL_HIGH, \
+            .idle_level = RMT_IDLE_LEVEL_LOW,        \
+            .carrier_duty_percent = 33,              \
+            .carrier_en = false,                     \
+            .loop_en = false,                        \
+            .idle_output_en = true,                  \
+        }                                            \
+    }
+#endif
+
+#ifndef RMT_DEFAULT_CONFIG_RX
+#define RMT_DEFAULT_CONFIG_RX(gpio, channel_id)      \
+    {                                                \
+        .rmt_mode = RMT_MODE_RX,                     \
+        .channel = channel_id,                       \
+        .gpio_num = gpio,                            \
+        .clk_div = 80,                               \
+        .mem_block_num = 1,                          \
+        .rx_config = {                               \
+            .idle_threshold = 12000,                 \
+            .filter_ticks_thresh = 100,              \
+            .filter_en = true,                       \
+        }                                            \
+    }
+#endif
+#endif
+
 #define ONEWIRE_SELECT_ROM 0x55
 #define ONEWIRE_SKIP_ROM   0xcc
 #define ONEWIRE_SEARCH     0xf0
@@ -99,6 +163,246 @@ static void setup_pin(gpio_num_t pin, bool open_drain)
     gpio_set_pull_mode(pin, GPIO_PULLUP_ONLY);
 }
 
+#if CONFIG_ONEWIRE_RMT
+
+// RMT channels are clocked at 1 MHz, all durations are in microseconds
+#define RMT_CLK_DIV        80
+#define RMT_RESET_LOW      480
+#define RMT_SLOT           70
+#define RMT_WRITE_1_LOW    10
+#define RMT_WRITE_0_LOW    65
+#define RMT_READ_LOW       2
+#define RMT_READ_SAMPLE    13  // shorter low level is read as 1
+#define RMT_RX_IDLE        (RMT_SLOT + 5)
+#define RMT_RX_FILTER      30  // APB clock ticks
+#define RMT_RX_BUF_SIZE    512
+#define RMT_TIMEOUT_MS     100
+
+// Bytes transferred per RMT session. Transmitted items are refilled
+// by the driver, but received items with the end marker must fit into
+// one RMT memory block (64 items on ESP32/S2, 48 on S3/C3)
+#define RMT_WRITE_CHUNK    8
+#define RMT_READ_CHUNK     ((RMT_MEM_ITEMS - 1) / 8)
+
+typedef struct
+{
+    rmt_channel_t tx;
+    rmt_channel_t rx;
+    RingbufHandle_t rb;
+    bool attached;
+} rmt_bus_t;
+
+static rmt_bus_t *rmt_buses[GPIO_NUM_MAX] = { 0 };
+
+static inline rmt_bus_t *rmt_bus(gpio_num_t pin)
+{
+    return pin >= 0 && pin < GPIO_NUM_MAX ? rmt_buses[pin] : NULL;
+}
+
+static inline rmt_item32_t rmt_slot(uint32_t low)
+{
+    rmt_item32_t item = { 0 };
+    item.level0 = 0;
+    item.duration0 = low;
+    item.level1 = 1;
+    item.duration1 = RMT_SLOT - low;
+    return item;
+}
+
+// Connect both RMT channels to the pin in open-drain mode. Must be done
+// again after the pin was reconfigured by onewire_power()/onewire_depower()
+static void rmt_attach(gpio_num_t pin, rmt_bus_t *bus)
+{
+    gpio_set_pull_mode(pin, GPIO_PULLUP_ONLY);
+    gpio_set_level(pin, 1);
+    rmt_connect_pin(bus->rx, RMT_MODE_RX, pin);
+    // Open drain with input enabled loops TX output back to RX channel
+    // through the pad. Direction change routes GPIO output signal to the
+    // pin (as rmt_set_gpio() for TX would switch it to push-pull output),
+    // so TX signal is connected afterwards.
+    gpio_set_direction(pin, GPIO_MODE_INPUT_OUTPUT_OD);
+    connect_out_signal(pin, RMT_TX_SIGNAL(bus->tx));
+    bus->attached = true;
+}
+
+static void rmt_flush_rx(rmt_bus_t *bus)
+{
+    void *item;
+    size_t size;
+    while ((item = xRingbufferReceive(bus->rb, &size, 0)))
+        vRingbufferReturnItem(bus->rb, item);
+}
+
+// Transmit slots and receive them back from the bus, returns number
+// of received items or -1 on error
+static int rmt_transceive(rmt_bus_t *bus, const rmt_item32_t *tx, size_t count, rmt_item32_t *rx, size_t rx_count)
+{
+    rmt_flush_rx(bus);
+    rmt_rx_start(bus->rx, true);
+
+    int res = -1;
+    if (rmt_write_items(bus->tx, tx, count, true) == ESP_OK)
+    {
+        size_t size = 0;
+        rmt_item32_t *items = xRingbufferReceive(bus->rb, &size, pdMS_TO_TICKS(RMT_TIMEOUT_MS));
+        if (items)
+        {
+            res = size / sizeof(rmt_item32_t);
+            if (res > (int)rx_count)
+                res = rx_count;
+            memcpy(rx, items, res * sizeof(rmt_item32_t));
+            vRingbufferReturnItem(bus->rb, items);
+        }
+    }
+
+    rmt_rx_stop(bus->rx);
+    return res;
+}
+
+static bool rmt_reset(gpio_num_t pin, rmt_bus_t *bus)
+{
+    if (!bus->attached)
+        rmt_attach(pin, bus);
+    if (!_onewire_wait_for_bus(pin, 250))
+        return false;
+
+    rmt_item32_t tx = { 0 };
+    tx.level0 = 0;
+    tx.duration0 = RMT_RESET_LOW;
+    tx.level1 = 1;
+    tx.duration1 = 0;
+
+    // presence pulse starts up to 60 us after reset pulse
+    uint16_t idle;
+    rmt_get_rx_idle_thresh(bus->rx, &idle);
+    rmt_set_rx_idle_thresh(bus->rx, RMT_RESET_LOW + 60);
+    rmt_item32_t rx[2];
+    int count = rmt_transceive(bus, &tx, 1, rx, 2);
+    rmt_set_rx_idle_thresh(bus->rx, idle);
+
+    if (count < 2)
+        return false;
+
+    return rx[0].level0 == 0 && rx[0].duration0 >= RMT_RESET_LOW - 2
+           && rx[0].level1 == 1 && rx[0].duration1 > 0
+           && rx[1].level0 == 0;
+}
+
+static bool rmt_write_bits(gpio_num_t pin, rmt_bus_t *bus, const uint8_t *buf, size_t bits)
+{
+    if (!bus->attached)
+        rmt_attach(pin, bus);
+
+    rmt_item32_t tx[RMT_WRITE_CHUNK * 8];
+    while (bits)
+    {
+        size_t count = bits > RMT_WRITE_CHUNK * 8 ? RMT_WRITE_CHUNK * 8 : bits;
+        for (size_t i = 0; i < count; i++)
+            tx[i] = rmt_slot(buf[i / 8] & (1 << (i % 8)) ? RMT_WRITE_1_LOW : RMT_WRITE_0_LOW);
+        if (rmt_write_items(bus->tx, tx, count, true) != ESP_OK)
+            return false;
+        buf += RMT_WRITE_CHUNK;
+        bits -= count;
+    }
+
+    return true;
+}
+
+static bool rmt_read_bits(gpio_num_t pin, rmt_bus_t *bus, uint8_t *buf, size_t bits)
+{
+    if (!bus->attached)
+        rmt_attach(pin, bus);
+
+    rmt_item32_t tx[RMT_READ_CHUNK * 8];
+    rmt_item32_t rx[RMT_READ_CHUNK * 8];
+    for (size_t i = 0; i < RMT_READ_CHUNK * 8; i++)
+        tx[i] = rmt_slot(RMT_READ_LOW);
+
+    while (bits)
+    {
+        size_t count = bits > RMT_READ_CHUNK * 8 ? RMT_READ_CHUNK * 8 : bits;
+        if (rmt_transceive(bus, tx, count, rx, count) != (int)count)
+            return false;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (i % 8 == 0)
+                buf[i / 8] = 0;
+            if (rx[i].level0 == 0 && rx[i].duration0 < RMT_READ_SAMPLE)
+                buf[i / 8] |= 1 << (i % 8);
+        }
+        buf += RMT_READ_CHUNK;
+        bits -= count;
+    }
+
+    return true;
+}
+
+esp_err_t onewire_rmt_init(gpio_num_t pin, rmt_channel_t tx_channel, rmt_channel_t rx_channel)
+{
+    if (!GPIO_IS_VALID_OUTPUT_GPIO(pin) || tx_channel == rx_channel || rmt_buses[pin])
+        return ESP_ERR_INVALID_ARG;
+
+    rmt_bus_t *bus = calloc(1, sizeof(rmt_bus_t));
+    if (!bus)
+        return ESP_ERR_NO_MEM;
+    bus->tx = tx_channel;
+    bus->rx = rx_channel;
+
+    rmt_config_t tx = RMT_DEFAULT_CONFIG_TX(pin, tx_channel);
+    tx.clk_div = RMT_CLK_DIV;
+    tx.tx_config.idle_output_en = true;
+    tx.tx_config.idle_level = RMT_IDLE_LEVEL_HIGH;
+
+    rmt_config_t rx = RMT_DEFAULT_CONFIG_RX(pin, rx_channel);
+    rx.clk_div = RMT_CLK_DIV;
+    rx.rx_config.filter_en = true;
+    rx.rx_config.filter_ticks_thresh = RMT_RX_FILTER;
+    rx.rx_config.idle_threshold = RMT_RX_IDLE;
+
+    esp_err_t res = rmt_config(&tx);
+    if (res == ESP_OK)
+        res = rmt_config(&rx);
+    if (res == ESP_OK)
+        res = rmt_driver_install(tx_channel, 0, 0);
+    if (res != ESP_OK)
+    {
+        free(bus);
+        return res;
+    }
+    res = rmt_driver_install(rx_channel, RMT_RX_BUF_SIZE, 0);
+    if (res == ESP_OK)
+        res = rmt_get_ringbuf_handle(rx_channel, &bus->rb);
+    if (res != ESP_OK)
+    {
+        rmt_driver_uninstall(rx_channel);
+        rmt_driver_uninstall(tx_channel);
+        free(bus);
+        return res;
+    }
+
+    rmt_attach(pin, bus);
+    rmt_buses[pin] = bus;
+
+    return ESP_OK;
+}
+
+esp_err_t onewire_rmt_free(gpio_num_t pin)
+{
+    rmt_bus_t *bus = rmt_bus(pin);
+    if (!bus)
+        return ESP_ERR_INVALID_ARG;
+
+    rmt_buses[pin] = NULL;
+    rmt_driver_uninstall(bus->rx);
+    rmt_driver_uninstall(bus->tx);
+    free(bus);
+    setup_pin(pin, true);
+
+    return ESP_OK;
+}
+
+#endif /* CONFIG_ONEWIRE_RMT */
+
 // Perform the onewire reset function.  We will wait up to 250uS for
 // the bus to come high, if it doesn't then it is broken or shorted
 // and we return false;
@@ -107,6 +411,12 @@ static void setup_pin(gpio_num_t pin, bool open_drain)
 //
 bool onewire_reset(gpio_num_t pin)
 {
+#if CONFIG_ONEWIRE_RMT
+    rmt_bus_t *bus = rmt_bus(pin);
+    if (bus)
+        return rmt_reset(pin, bus);
+#endif
+
     setup_pin(pin, true);
 
     gpio_set_level(pin, 1);
@@ -154,6 +464,15 @@ static bool _onewire_write_bit(gpio_num_t pin, bool v)
     return true;
 }
 
+static bool _onewire_write_byte(gpio_num_t pin, uint8_t v)
+{
+    for (uint8_t bitMask = 0x01; bitMask; bitMask <<= 1)
+        if (!_onewire_write_bit(pin, (bitMask & v)))
+            return false;
+
+    return true;
+}
+
 static int _onewire_read_bit(gpio_num_t pin)
 {
     if (!_onewire_wait_for_bus(pin, 10))
@@ -171,6 +490,32 @@ static int _onewire_read_bit(gpio_num_t pin)
     return r;
 }
 
+static bool write_bit(gpio_num_t pin, bool v)
+{
+#if CONFIG_ONEWIRE_RMT
+    rmt_bus_t *bus = rmt_bus(pin);
+    if (bus)
+    {
+        uint8_t b = v;
+        return rmt_write_bits(pin, bus, &b, 1);
+    }
+#endif
+    return _onewire_write_bit(pin, v);
+}
+
+static int read_bit(gpio_num_t pin)
+{
+#if CONFIG_ONEWIRE_RMT
+    rmt_bus_t *bus = rmt_bus(pin);
+    if (bus)
+    {
+        uint8_t b;
+        return rmt_read_bits(pin, bus, &b, 1) ? b : -1;
+    }
+#endif
+    return _onewire_read_bit(pin);
+}
+
 // Write a byte. The writing code uses open-drain mode and expects the pullup
 // resistor to pull the line high when not driven low.  If you need strong
 // power after the write (e.g. DS18B20 in parasite power mode) then call
@@ -178,15 +523,23 @@ static int _onewire_read_bit(gpio_num_t pin)
 //
 bool onewire_write(gpio_num_t pin, uint8_t v)
 {
-    for (uint8_t bitMask = 0x01; bitMask; bitMask <<= 1)
-        if (!_onewire_write_bit(pin, (bitMask & v)))
-            return false;
+#if CONFIG_ONEWIRE_RMT
+    rmt_bus_t *bus = rmt_bus(pin);
+    if (bus)
+        return rmt_write_bits(pin, bus, &v, 8);
+#endif
 
-    return true;
+    return _onewire_write_byte(pin, v);
 }
 
 bool onewire_write_bytes(gpio_num_t pin, const uint8_t *buf, size_t count)
 {
+#if CONFIG_ONEWIRE_RMT
+    rmt_bus_t *bus = rmt_bus(pin);
+    if (bus)
+        return rmt_write_bits(pin, bus, buf, count * 8);
+#endif
+
     for (size_t i = 0; i < count; i++)
         if (!onewire_write(pin, buf[i]))
             return false;
@@ -198,6 +551,15 @@ bool onewire_write_bytes(gpio_num_t pin, const uint8_t *buf, size_t count)
 //
 int onewire_read(gpio_num_t pin)
 {
+#if CONFIG_ONEWIRE_RMT
+    rmt_bus_t *bus = rmt_bus(pin);
+    if (bus)
+    {
+        uint8_t b;
+        return rmt_read_bits(pin, bus, &b, 8) ? b : -1;
+    }
+#endif
+
     int r = 0;
 
     for (uint8_t bitMask = 0x01; bitMask; bitMask <<= 1)
@@ -213,6 +575,12 @@ int onewire_read(gpio_num_t pin)
 
 bool onewire_read_bytes(gpio_num_t pin, uint8_t *buf, size_t count)
 {
+#if CONFIG_ONEWIRE_RMT
+    rmt_bus_t *bus = rmt_bus(pin);
+    if (bus)
+        return rmt_read_bits(pin, bus, buf, count * 8);
+#endif
+
     size_t i;
     int b;
 
@@ -228,19 +596,16 @@ bool onewire_read_bytes(gpio_num_t pin, uint8_t *buf, size_t count)
 
 bool onewire_select(gpio_num_t pin, onewire_addr_t addr)
 {
-    uint8_t i;
+    uint8_t buf[9];
 
-    if (!onewire_write(pin, ONEWIRE_SELECT_ROM))
-        return false;
-
-    for (i = 0; i < 8; i++)
+    buf[0] = ONEWIRE_SELECT_ROM;
+    for (int i = 1; i < 9; i++)
     {
-        if (!onewire_write(pin, addr & 0xff))
-            return false;
+        buf[i] = addr & 0xff;
         addr >>= 8;
     }
 
-    return true;
+    return onewire_write_bytes(pin, buf, sizeof(buf));
 }
 
 bool onewire_skip_rom(gpio_num_t pin)
@@ -255,14 +620,47 @@ bool onewire_power(gpio_num_t pin)
     if (!_onewire_wait_for_bus(pin, 10))
         return false;
 
+#if CONFIG_ONEWIRE_RMT
+    // pin is disconnected from RMT channels until next operation
+    rmt_bus_t *bus = rmt_bus(pin);
+    if (bus)
+        bus->attached = false;
+#endif
     setup_pin(pin, false);
     gpio_set_level(pin, 1);
 
     return true;
 }
 
+bool onewire_write_power(gpio_num_t pin, uint8_t v)
+{
+#if CONFIG_ONEWIRE_RMT
+    // RMT driver wakes up the task too late to apply strong pull-up
+    // within 10us, so the byte is bit-banged. Pin is connected back
+    // to RMT channels by the next operation.
+    rmt_bus_t *bus = rmt_bus(pin);
+    if (bus)
+    {
+        bus->attached = false;
+        setup_pin(pin, true);
+        gpio_set_level(pin, 1);
+    }
+#endif
+
+    PORT_ENTER_CRITICAL;
+    bool res = _onewire_write_byte(pin, v) && onewire_power(pin);
+    PORT_EXIT_CRITICAL;
+
+    return res;
+}
+
 void onewire_depower(gpio_num_t pin)
 {
+#if CONFIG_ONEWIRE_RMT
+    rmt_bus_t *bus = rmt_bus(pin);
+    if (bus)
+        bus->attached = false;
+#endif
     setup_pin(pin, true);
 }
 
@@ -335,8 +733,8 @@ onewire_addr_t onewire_search_next(onewire_search_t *search, gpio_num_t pin)
         do
         {
             // read a bit and its complement
-            id_bit = _onewire_read_bit(pin);
-            cmp_id_bit = _onewire_read_bit(pin);
+            id_bit = read_bit(pin);
+            cmp_id_bit = read_bit(pin);
 
             if ((id_bit == 1) && (cmp_id_bit == 1))
                 break;
@@ -368,7 +766,7 @@ onewire_addr_t onewire_search_next(onewire_search_t *search, gpio_num_t pin)
                     search->rom_no[rom_byte_number] &= ~rom_byte_mask;
 
                 // serial number search direction write bit
-                _onewire_write_bit(pin, search_direction);
+                write_bit(pin, search_direction);
 
                 // increment the byte counter id_bit_number
                 // and shift the mask rom_byte_mask
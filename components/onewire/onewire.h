@@ -56,6 +56,10 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <driver/gpio.h>
+#include <esp_err.h>
+#if CONFIG_ONEWIRE_RMT
+#include <driver/rmt.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -83,6 +87,38 @@ typedef struct
  */
 #define ONEWIRE_NONE ((onewire_addr_t)(0xffffffffffffffffLL))
 
+#if CONFIG_ONEWIRE_RMT || defined(__DOXYGEN__)
+
+/**
+ * @brief Drive 1-Wire bus with RMT peripheral
+ *
+ * After this call all functions of this library called with \p pin
+ * generate and sample bus time slots with two RMT channels instead of
+ * bit-banging. Calling task sleeps while bus transfer is in progress,
+ * CPU is not busy and interrupts are not disabled. Pins not registered
+ * with this function are still bit-banged.
+ *
+ * Option CONFIG_ONEWIRE_RMT must be enabled.
+ *
+ * @param pin         The GPIO pin connected to the 1-Wire bus.
+ * @param tx_channel  RMT channel used to generate time slots
+ * @param rx_channel  RMT channel used to sample the bus
+ * @return `ESP_OK` on success
+ */
+esp_err_t onewire_rmt_init(gpio_num_t pin, rmt_channel_t tx_channel, rmt_channel_t rx_channel);
+
+/**
+ * @brief Release RMT channels of 1-Wire bus
+ *
+ * Bus will be bit-banged after this call.
+ *
+ * @param pin  The GPIO pin connected to the 1-Wire bus.
+ * @return `ESP_OK` on success
+ */
+esp_err_t onewire_rmt_free(gpio_num_t pin);
+
+#endif
+
 /**
  * @brief Perform a 1-Wire reset cycle.
  *
@@ -197,6 +233,21 @@ bool onewire_read_bytes(gpio_num_t pin, uint8_t *buf, size_t count);
  */
 bool onewire_power(gpio_num_t pin);
 
+/**
+ * @brief Write a byte and then actively drive the bus high.
+ *
+ * Parasitically-powered devices need strong power within 10 us after
+ * a command such as "convert T", so the byte is written and power is
+ * applied in one critical section. On buses driven by RMT peripheral
+ * this byte is bit-banged as well.
+ *
+ * @param pin    The GPIO pin connected to the 1-Wire bus.
+ * @param v      The byte value to write
+ *
+ * @return `true` on success, `false` on error.
+ */
+bool onewire_write_power(gpio_num_t pin, uint8_t v);
+
 /**
  * @brief Stop forcing power onto the bus.
  *
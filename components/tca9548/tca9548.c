@@ -82,7 +82,7 @@ esp_err_t tca9548_set_channels(i2c_dev_t *dev, uint8_t channels)
     CHECK_ARG(dev);
 
     I2C_DEV_TAKE_MUTEX(dev);
-    I2C_DEV_CHECK(dev, i2c_dev_write(dev, NULL, 0, &channels, 1));
+    I2C_DEV_CHECK(dev, i2cdev_mux_select(dev, channels));
     I2C_DEV_GIVE_MUTEX(dev);
     ESP_LOGD(TAG, "[0x%02x at %d] Channels set to 0x%02x (0b" BYTE_TO_BINARY_PATTERN ")",
             dev->addr, dev->port, channels, BYTE_TO_BINARY(channels));
@@ -100,3 +100,17 @@ esp_err_t tca9548_get_channels(i2c_dev_t *dev, uint8_t *channels)
 
     return ESP_OK;
 }
+
+esp_err_t tca9548_attach(const i2c_dev_t *dev, i2c_dev_t *child, uint8_t channel)
+{
+    CHECK_ARG(dev && child && channel < 8 && child->port == dev->port);
+
+    return i2c_dev_set_mux(child, dev->addr, channel);
+}
+
+esp_err_t tca9548_detach(i2c_dev_t *child)
+{
+    CHECK_ARG(child);
+
+    return i2c_dev_set_mux(child, 0, 0);
+}
@@ -98,6 +98,29 @@ esp_err_t tca9548_free_desc(i2c_dev_t *dev);
  */
 esp_err_t tca9548_set_channels(i2c_dev_t *dev, uint8_t channels);
 
+/**
+ * @brief Attach device to a channel of the switch
+ *
+ * After this call all transactions of \p child automatically select
+ * \p channel on the switch, which is written only when the channel changes.
+ * No need to call ::tca9548_set_channels() before accessing the device.
+ * Descriptor of \p child must be initialized (port must be set).
+ *
+ * @param dev Switch descriptor
+ * @param child Descriptor of device connected to the switch
+ * @param channel Channel number, 0..7
+ * @return `ESP_OK` on success
+ */
+esp_err_t tca9548_attach(const i2c_dev_t *dev, i2c_dev_t *child, uint8_t channel);
+
+/**
+ * @brief Detach device from the switch
+ *
+ * @param child Descriptor of device connected to the switch
+ * @return `ESP_OK` on success
+ */
+esp_err_t tca9548_detach(i2c_dev_t *child);
+
 /**
  * @brief Read current channels configuration
  *
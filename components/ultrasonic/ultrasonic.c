@@ -40,7 +40,10 @@
 #include "ultrasonic.h"
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <stdlib.h>
 #include <esp_timer.h>
+#include <esp_log.h>
 #include <ets_sys.h>
 
 #define TRIGGER_LOW_DELAY 4
@@ -49,6 +52,8 @@
 #define ROUNDTRIP_M 5800.0f
 #define ROUNDTRIP_CM 58
 
+static const char *TAG = "ultrasonic";
+
 #if HELPER_TARGET_IS_ESP32
 static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
 #define PORT_ENTER_CRITICAL portENTER_CRITICAL(&mux)
@@ -68,6 +73,129 @@ static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
 #define CHECK(x) do { esp_err_t __; if ((__ = x) != ESP_OK) return __; } while (0)
 #define RETURN_CRITICAL(RES) do { PORT_EXIT_CRITICAL; return RES; } while(0)
 
+typedef struct
+{
+    const ultrasonic_sensor_t *dev;
+    size_t index;
+    SemaphoreHandle_t done;
+    bool busy;
+    volatile int64_t start;
+    volatile int64_t end;
+} echo_t;
+
+#if HELPER_TARGET_IS_ESP32
+static void IRAM_ATTR echo_isr(void *arg)
+#else
+static void echo_isr(void *arg)
+#endif
+{
+    echo_t *e = (echo_t *)arg;
+    int64_t now = esp_timer_get_time();
+
+    if (gpio_get_level(e->dev->echo_pin))
+    {
+        if (!e->start)
+            e->start = now;
+        return;
+    }
+    if (!e->start || e->end)
+        return;
+    e->end = now;
+
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(e->done, &woken);
+    if (woken == pdTRUE)
+        portYIELD_FROM_ISR();
+}
+
+static esp_err_t install_isr_service()
+{
+    static bool installed = false;
+
+    if (installed)
+        return ESP_OK;
+    esp_err_t res = gpio_install_isr_service(0);
+    if (res != ESP_OK && res != ESP_ERR_INVALID_STATE)
+        return res;
+    installed = true;
+
+    return ESP_OK;
+}
+
+/**
+ * Ping sensors simultaneously and capture their echoes. `done` is a
+ * counting semaphore given once for each ended echo, it must not be
+ * used by anything else.
+ * Returns time of the end of the trigger pulse.
+ */
+static int64_t ping_slot(echo_t *echoes, size_t count, uint32_t max_time_us, SemaphoreHandle_t done)
+{
+    size_t pending = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        echo_t *e = &echoes[i];
+        e->done = done;
+        e->start = 0;
+        e->end = 0;
+        gpio_set_level(e->dev->trigger_pin, 0);
+        // Previous ping isn't ended
+        e->busy = gpio_get_level(e->dev->echo_pin);
+        if (e->busy)
+            continue;
+        gpio_isr_handler_add(e->dev->echo_pin, echo_isr, e);
+        gpio_set_intr_type(e->dev->echo_pin, GPIO_INTR_ANYEDGE);
+        pending++;
+    }
+
+    // Ping: Low for 2..4 us, then high 10 us
+    ets_delay_us(TRIGGER_LOW_DELAY);
+    for (size_t i = 0; i < count; i++)
+        if (!echoes[i].busy)
+            gpio_set_level(echoes[i].dev->trigger_pin, 1);
+    ets_delay_us(TRIGGER_HIGH_DELAY);
+    for (size_t i = 0; i < count; i++)
+        gpio_set_level(echoes[i].dev->trigger_pin, 0);
+    int64_t ping = esp_timer_get_time();
+
+    // Sleep until all echoes are ended
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS((PING_TIMEOUT + max_time_us) / 1000 + 1) + 1;
+    while (pending)
+    {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout || xSemaphoreTake(done, timeout - elapsed) != pdTRUE)
+            break;
+        pending--;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (echoes[i].busy)
+            continue;
+        gpio_set_intr_type(echoes[i].dev->echo_pin, GPIO_INTR_DISABLE);
+        gpio_isr_handler_remove(echoes[i].dev->echo_pin);
+    }
+    // Echoes ended after the timeout must not be counted in the next slot
+    while (xSemaphoreTake(done, 0) == pdTRUE)
+        ;
+
+    return ping;
+}
+
+static esp_err_t echo_result(const echo_t *e, int64_t ping, uint32_t max_time_us, uint32_t *time_us)
+{
+    if (e->busy)
+        return ESP_ERR_ULTRASONIC_PING;
+    if (!e->start || e->start - ping > PING_TIMEOUT)
+        return ESP_ERR_ULTRASONIC_PING_TIMEOUT;
+    if (!e->end || e->end - e->start > max_time_us)
+        return ESP_ERR_ULTRASONIC_ECHO_TIMEOUT;
+    *time_us = e->end - e->start;
+
+    return ESP_OK;
+}
+
 esp_err_t ultrasonic_init(const ultrasonic_sensor_t *dev)
 {
     CHECK_ARG(dev);
@@ -83,6 +211,19 @@ esp_err_t ultrasonic_measure_raw(const ultrasonic_sensor_t *dev, uint32_t max_ti
 {
     CHECK_ARG(dev && time_us);
 
+#if CONFIG_ULTRASONIC_EDGE_CAPTURE
+    CHECK(install_isr_service());
+
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(1, 0);
+    if (!done)
+        return ESP_ERR_NO_MEM;
+
+    echo_t echo = { .dev = dev };
+    int64_t ping = ping_slot(&echo, 1, max_time_us, done);
+    vSemaphoreDelete(done);
+
+    return echo_result(&echo, ping, max_time_us, time_us);
+#else
     PORT_ENTER_CRITICAL;
 
     // Ping: Low for 2..4 us, then high 10 us
@@ -118,6 +259,7 @@ esp_err_t ultrasonic_measure_raw(const ultrasonic_sensor_t *dev, uint32_t max_ti
     *time_us = time - echo_start;
 
     return ESP_OK;
+#endif
 }
 
 esp_err_t ultrasonic_measure(const ultrasonic_sensor_t *dev, float max_distance, float *distance)
@@ -141,3 +283,162 @@ esp_err_t ultrasonic_measure_cm(const ultrasonic_sensor_t *dev, uint32_t max_dis
 
     return ESP_OK;
 }
+
+// Private state of sensor array
+typedef struct
+{
+    SemaphoreHandle_t done;    // ended echoes of the current slot
+    SemaphoreHandle_t stopped; // given by array task when it leaves the loop
+    echo_t echoes[];
+} array_state_t;
+
+static void array_deliver(ultrasonic_array_t *array, const ultrasonic_sample_t *sample)
+{
+    if (array->queue && xQueueSend(array->queue, sample, 0) != pdTRUE)
+        ESP_LOGW(TAG, "Result queue overflow, distance of sensor #%u discarded", (unsigned)sample->index);
+    if (array->callback)
+        array->callback(sample, array->ctx);
+}
+
+/**
+ * Collect sensors of the next slot, return number of sensors in it
+ */
+static size_t next_slot(const ultrasonic_array_t *array, int *slot, echo_t *echoes)
+{
+    size_t count = 0;
+
+    if (!array->groups)
+    {
+        if ((size_t)(*slot + 1) >= array->count)
+            return 0;
+        (*slot)++;
+        echoes[count++].index = *slot;
+        return count;
+    }
+
+    int group = UINT8_MAX + 1;
+    for (size_t i = 0; i < array->count; i++)
+        if (array->groups[i] > *slot && array->groups[i] < group)
+            group = array->groups[i];
+    if (group > UINT8_MAX)
+        return 0;
+
+    for (size_t i = 0; i < array->count; i++)
+        if (array->groups[i] == group)
+            echoes[count++].index = i;
+    *slot = group;
+
+    return count;
+}
+
+static void array_task(void *arg)
+{
+    ultrasonic_array_t *array = (ultrasonic_array_t *)arg;
+    array_state_t *state = (array_state_t *)array->state;
+    echo_t *echoes = state->echoes;
+    uint32_t max_time_us = array->max_distance * ROUNDTRIP_M;
+
+    TickType_t cycle_start = xTaskGetTickCount();
+    while (array->running)
+    {
+        int slot = -1;
+        size_t count;
+        while (array->running && (count = next_slot(array, &slot, echoes)) > 0)
+        {
+            for (size_t i = 0; i < count; i++)
+                echoes[i].dev = &array->sensors[echoes[i].index];
+
+            int64_t ping = ping_slot(echoes, count, max_time_us, state->done);
+
+            for (size_t i = 0; i < count; i++)
+            {
+                ultrasonic_sample_t sample = {
+                    .index = echoes[i].index,
+                    .timestamp = echoes[i].end ? echoes[i].end : esp_timer_get_time(),
+                };
+                sample.result = echo_result(&echoes[i], ping, max_time_us, &sample.time_us);
+                if (sample.result == ESP_OK)
+                    sample.distance = sample.time_us / ROUNDTRIP_M;
+                array_deliver(array, &sample);
+            }
+
+            // let echoes of this slot fade out before the next one is pinged
+            if (array->slot_delay_ms)
+                vTaskDelay(pdMS_TO_TICKS(array->slot_delay_ms));
+        }
+
+        // idle for the rest of the period, notification from
+        // ultrasonic_array_stop() cuts the pause short
+        TickType_t period = pdMS_TO_TICKS(array->period_ms);
+        TickType_t spent = xTaskGetTickCount() - cycle_start;
+        if (array->running && spent < period)
+            ulTaskNotifyTake(pdTRUE, period - spent);
+        cycle_start = xTaskGetTickCount();
+    }
+
+    // ultrasonic_array_stop() deletes the task after it takes the semaphore
+    xSemaphoreGive(state->stopped);
+    vTaskSuspend(NULL);
+}
+
+static void array_state_free(ultrasonic_array_t *array)
+{
+    array_state_t *state = (array_state_t *)array->state;
+
+    if (state->done)
+        vSemaphoreDelete(state->done);
+    if (state->stopped)
+        vSemaphoreDelete(state->stopped);
+    free(state);
+    array->state = NULL;
+}
+
+esp_err_t ultrasonic_array_start(ultrasonic_array_t *array)
+{
+    CHECK_ARG(array && array->sensors && array->count && array->max_distance > 0
+            && (array->queue || array->callback) && !array->task);
+
+    for (size_t i = 0; i < array->count; i++)
+        CHECK(ultrasonic_init(&array->sensors[i]));
+    CHECK(install_isr_service());
+
+    array_state_t *state = calloc(1, sizeof(array_state_t) + array->count * sizeof(echo_t));
+    if (!state)
+        return ESP_ERR_NO_MEM;
+    array->state = state;
+    state->done = xSemaphoreCreateCounting(array->count, 0);
+    state->stopped = xSemaphoreCreateBinary();
+
+    array->running = true;
+    if (!state->done || !state->stopped
+            || xTaskCreate(array_task, "ultrasonic", CONFIG_ULTRASONIC_ARRAY_TASK_STACK_SIZE, array,
+                    CONFIG_ULTRASONIC_ARRAY_TASK_PRIORITY, &array->task) != pdPASS)
+    {
+        array->running = false;
+        array->task = NULL;
+        array_state_free(array);
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t ultrasonic_array_stop(ultrasonic_array_t *array)
+{
+    CHECK_ARG(array);
+
+    // handle stays valid: the task only suspends itself on exit
+    TaskHandle_t task = array->task;
+    // the task would wait for itself
+    if (!task || task == xTaskGetCurrentTaskHandle())
+        return ESP_ERR_INVALID_STATE;
+
+    array->running = false;
+    xTaskNotifyGive(task);
+    xSemaphoreTake(((array_state_t *)array->state)->stopped, portMAX_DELAY);
+    vTaskDelete(task);
+    array->task = NULL;
+    array_state_free(array);
+
+    return ESP_OK;
+}
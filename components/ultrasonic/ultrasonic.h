@@ -41,7 +41,11 @@
 #ifndef __ULTRASONIC_H__
 #define __ULTRASONIC_H__
 
+#include <stdbool.h>
 #include <driver/gpio.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
 #include <esp_err.h>
 
 #ifdef __cplusplus
@@ -61,6 +65,47 @@ typedef struct
     gpio_num_t echo_pin;    //!< GPIO input pin for echo
 } ultrasonic_sensor_t;
 
+/**
+ * Result of a single measurement in sensor array
+ */
+typedef struct
+{
+    size_t index;      //!< Index of the sensor in the array
+    esp_err_t result;  //!< Result of measurement
+    uint32_t time_us;  //!< Echo duration, us, valid if result is `ESP_OK`
+    float distance;    //!< Distance in meters, valid if result is `ESP_OK`
+    int64_t timestamp; //!< End of echo, microseconds since boot
+} ultrasonic_sample_t;
+
+/**
+ * Sample callback prototype
+ */
+typedef void (*ultrasonic_sample_cb_t)(const ultrasonic_sample_t *sample, void *ctx);
+
+/**
+ * Sensor array descriptor
+ *
+ * Sensors are pinged in slots: all sensors of the same group are pinged
+ * simultaneously, groups are pinged one after another in ascending order
+ * of their numbers. Sensors which can hear each other should be placed
+ * in different groups.
+ */
+typedef struct
+{
+    const ultrasonic_sensor_t *sensors; //!< Sensors
+    const uint8_t *groups;              //!< Group number of each sensor, NULL to ping sensors one by one
+    size_t count;                       //!< Number of sensors
+    float max_distance;                 //!< Maximal distance to measure, meters
+    uint32_t slot_delay_ms;             //!< Pause after each slot to let echoes fade out, ms
+    uint32_t period_ms;                 //!< Period of measurement cycles, ms. 0 for back-to-back cycles
+    QueueHandle_t queue;                //!< Queue of ::ultrasonic_sample_t to send samples to, can be NULL
+    ultrasonic_sample_cb_t callback;    //!< Function to call for each sample, can be NULL
+    void *ctx;                          //!< Callback argument
+    void *state;                        //!< Echo capture state, managed by driver
+    TaskHandle_t task;                  //!< Measurement task, managed by driver
+    volatile bool running;              //!< Measurement is running, managed by driver
+} ultrasonic_array_t;
+
 /**
  * @brief Init ranging module
  *
@@ -72,6 +117,10 @@ esp_err_t ultrasonic_init(const ultrasonic_sensor_t *dev);
 /**
  * @brief Measure time between ping and echo
  *
+ * If CONFIG_ULTRASONIC_EDGE_CAPTURE is enabled, echo edges are timestamped
+ * in GPIO interrupt handler and the caller sleeps while waiting for them,
+ * otherwise echo pin is polled with interrupts disabled.
+ *
  * @param dev Pointer to the device descriptor
  * @param max_time_us Maximal time to wait for echo
  * @param[out] time_us Time, us
@@ -108,6 +157,41 @@ esp_err_t ultrasonic_measure(const ultrasonic_sensor_t *dev, float max_distance,
  */
 esp_err_t ultrasonic_measure_cm(const ultrasonic_sensor_t *dev, uint32_t max_distance, uint32_t *distance);
 
+/**
+ * @brief Start periodic measurements of sensor array in background
+ *
+ * Initializes sensors and creates a task which pings sensors in slots
+ * (see ::ultrasonic_array_t) every `period_ms` milliseconds and passes
+ * samples to `queue` and/or `callback`. Echo edges are timestamped in GPIO
+ * interrupt handler, so interrupts are not disabled during measurement.
+ * Fields `sensors`, `groups`, `count`, `max_distance`, `slot_delay_ms`,
+ * `period_ms`, `queue`, `callback` and `ctx` must be set before calling
+ * this function, other fields must be zeroed. `sensors` and `groups` must
+ * stay valid until measurements are stopped.
+ *
+ * @note GPIO ISR service is installed by this function if it is not
+ *       installed yet.
+ *
+ * @param array Sensor array descriptor
+ * @return `ESP_OK` on success
+ */
+esp_err_t ultrasonic_array_start(ultrasonic_array_t *array);
+
+/**
+ * @brief Stop periodic measurements of sensor array
+ *
+ * Remaining slots of the current cycle are skipped, only the slot being
+ * measured is finished. Then the measurement task is deleted.
+ *
+ * Must not be called from the sample callback, which runs in the
+ * measurement task.
+ *
+ * @param array Sensor array descriptor
+ * @return `ESP_OK` on success, `ESP_ERR_INVALID_STATE` if measurements
+ *         are not running or function is called from the measurement task
+ */
+esp_err_t ultrasonic_array_stop(ultrasonic_array_t *array);
+
 #ifdef __cplusplus
 }
 #endif
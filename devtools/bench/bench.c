@@ -0,0 +1,457 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2021 Ruslan V. Uss <unclerus@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file bench.c
+ *
+ * Host benchmarks for pure-compute components: color, noise, lib8tion
+ * and framebuffer.
+ *
+ * Every benchmark processes one frame of `width * height` pixels per
+ * iteration and is repeated until minimal run time is reached. Results are
+ * printed as JSON lines or CSV, one benchmark per line.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <esp_timer.h>
+#include <lib8tion.h>
+#include <color.h>
+#include <noise.h>
+#include <framebuffer.h>
+
+typedef struct
+{
+    const char *component;
+    const char *name;
+    void (*run)(void);
+} bench_t;
+
+static size_t width = 32;
+static size_t height = 32;
+static size_t num;
+
+static rgb_t *src;
+static rgb_t *dst;
+static rgb_t *overlay;
+static hsv_t *hsv;
+static uint8_t *field;
+static framebuffer_t fb;
+static rgb_lut_t lut;
+static hue_table_t hue_table;
+static rgb_t palette[16];
+static rgb_palette_t rgb_palette;
+static uint16_t frame;
+
+// keeps results alive, so the compiler can't drop computations
+static volatile uint32_t sink;
+
+static size_t xy(void *ctx, size_t x, size_t y)
+{
+    (void)ctx;
+    return y * width + x;
+}
+
+static esp_err_t render(framebuffer_t *f, void *arg)
+{
+    (void)f;
+    (void)arg;
+    return ESP_OK;
+}
+
+static void reload(void)
+{
+    memcpy(dst, src, num * sizeof(rgb_t));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// color
+
+static void b_hsv2rgb_rainbow(void)
+{
+    for (size_t i = 0; i < num; i++)
+        dst[i] = hsv2rgb_rainbow(hsv[i]);
+}
+
+static void b_hsv2rgb_rainbow_array(void)
+{
+    hsv2rgb_rainbow_array(hsv, dst, num);
+}
+
+static void b_hue_table_convert(void)
+{
+    hue_table_convert(&hue_table, field, dst, num);
+}
+
+static void b_hsv2rgb_spectrum(void)
+{
+    for (size_t i = 0; i < num; i++)
+        dst[i] = hsv2rgb_spectrum(hsv[i]);
+}
+
+static void b_rgb2hsv_approximate(void)
+{
+    for (size_t i = 0; i < num; i++)
+        hsv[i] = rgb2hsv_approximate(src[i]);
+}
+
+static void b_color_from_palette_rgb(void)
+{
+    for (size_t i = 0; i < num; i++)
+        dst[i] = color_from_palette_rgb(palette, 16, i + frame, 255, true);
+}
+
+static void b_rgb_palette_map(void)
+{
+    rgb_palette_map(&rgb_palette, field, dst, num);
+}
+
+static void b_blur1d(void)
+{
+    reload();
+    blur1d(dst, num, 64);
+}
+
+static void b_blur2d_callback(void)
+{
+    reload();
+    blur2d(dst, width, height, 64, xy, NULL);
+}
+
+static void b_blur2d_rowmajor(void)
+{
+    reload();
+    blur2d(dst, width, height, 64, NULL, NULL);
+}
+
+static void b_rgb_fade(void)
+{
+    reload();
+    for (size_t i = 0; i < num; i++)
+        dst[i] = rgb_fade(dst[i], 32);
+}
+
+static void b_rgb_array_fade(void)
+{
+    reload();
+    rgb_array_fade(dst, num, 32);
+}
+
+static void b_rgb_blend(void)
+{
+    reload();
+    for (size_t i = 0; i < num; i++)
+        dst[i] = rgb_blend(dst[i], overlay[i], 100);
+}
+
+static void b_rgb_array_blend(void)
+{
+    reload();
+    rgb_array_blend(dst, overlay, num, 100);
+}
+
+static void b_apply_gamma2rgb(void)
+{
+    for (size_t i = 0; i < num; i++)
+        dst[i] = apply_gamma2rgb(src[i], 2.2f);
+}
+
+static void b_rgb_array_gamma(void)
+{
+    reload();
+    rgb_array_gamma(dst, num, 2.2f);
+}
+
+static void b_rgb_array_apply_lut(void)
+{
+    reload();
+    rgb_array_apply_lut(dst, num, &lut);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// noise
+
+static void b_inoise8_2d(void)
+{
+    for (size_t y = 0; y < height; y++)
+        for (size_t x = 0; x < width; x++)
+            field[y * width + x] = inoise8_2d(x * 40, y * 40 + frame);
+}
+
+static void b_fill_noise8_2d(void)
+{
+    fill_noise8_2d(field, width, height, width, 1, 0, frame, 40, 40);
+}
+
+static void b_inoise8_3d(void)
+{
+    for (size_t y = 0; y < height; y++)
+        for (size_t x = 0; x < width; x++)
+            field[y * width + x] = inoise8_3d(x * 40, y * 40, frame);
+}
+
+static void b_fill_noise8_3d(void)
+{
+    fill_noise8_3d(field, width, height, width, 1, 0, 0, frame, 40, 40);
+}
+
+static void b_fill_noise8_3d_octaves(void)
+{
+    fill_noise8_3d(field, width, height, width, 3, 0, 0, frame, 40, 40);
+}
+
+static void b_inoise16_2d(void)
+{
+    for (size_t y = 0; y < height; y++)
+        for (size_t x = 0; x < width; x++)
+            field[y * width + x] = inoise16_2d(x << 12, (y << 12) + frame) >> 8;
+}
+
+static void b_fill_raw_noise8(void)
+{
+    for (size_t y = 0; y < height; y++)
+    {
+        memset(field + y * width, 0, width);
+        fill_raw_noise8(field + y * width, width, 1, 0, 40, y * 40 + frame);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// lib8tion
+
+static void b_sin8(void)
+{
+    uint32_t acc = 0;
+    for (size_t i = 0; i < num; i++)
+        acc += sin8(i + frame);
+    sink += acc;
+}
+
+static void b_sin16(void)
+{
+    uint32_t acc = 0;
+    for (size_t i = 0; i < num; i++)
+        acc += sin16((i << 6) + frame);
+    sink += acc;
+}
+
+static void b_sqrt16(void)
+{
+    uint32_t acc = 0;
+    for (size_t i = 0; i < num; i++)
+        acc += sqrt16((i << 4) + frame);
+    sink += acc;
+}
+
+static void b_random8(void)
+{
+    for (size_t i = 0; i < num; i++)
+        field[i] = random8();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// framebuffer
+
+static void fb_reload(void)
+{
+    memcpy(fb.data, src, num * sizeof(rgb_t));
+}
+
+static void b_fb_set_pixel_rgb(void)
+{
+    for (size_t y = 0; y < height; y++)
+        for (size_t x = 0; x < width; x++)
+            fb_set_pixel_rgb(&fb, x, y, src[(y * width + x + frame) % num]);
+}
+
+static void b_fb_fade(void)
+{
+    fb_reload();
+    fb_fade(&fb, 32);
+}
+
+static void b_fb_blur2d(void)
+{
+    fb_reload();
+    fb_blur2d(&fb, 64);
+}
+
+static void b_fb_shift(void)
+{
+    fb_shift(&fb, 1, frame & 1 ? FB_SHIFT_LEFT : FB_SHIFT_DOWN);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static const bench_t benches[] = {
+    { "color",       "hsv2rgb_rainbow",        b_hsv2rgb_rainbow },
+    { "color",       "hsv2rgb_rainbow_array",  b_hsv2rgb_rainbow_array },
+    { "color",       "hue_table_convert",      b_hue_table_convert },
+    { "color",       "hsv2rgb_spectrum",       b_hsv2rgb_spectrum },
+    { "color",       "rgb2hsv_approximate",    b_rgb2hsv_approximate },
+    { "color",       "color_from_palette_rgb", b_color_from_palette_rgb },
+    { "color",       "rgb_palette_map",        b_rgb_palette_map },
+    { "color",       "blur1d",                 b_blur1d },
+    { "color",       "blur2d_callback",        b_blur2d_callback },
+    { "color",       "blur2d_rowmajor",        b_blur2d_rowmajor },
+    { "color",       "rgb_fade",               b_rgb_fade },
+    { "color",       "rgb_array_fade",         b_rgb_array_fade },
+    { "color",       "rgb_blend",              b_rgb_blend },
+    { "color",       "rgb_array_blend",        b_rgb_array_blend },
+    { "color",       "apply_gamma2rgb",        b_apply_gamma2rgb },
+    { "color",       "rgb_array_gamma",        b_rgb_array_gamma },
+    { "color",       "rgb_array_apply_lut",    b_rgb_array_apply_lut },
+    { "noise",       "inoise8_2d",             b_inoise8_2d },
+    { "noise",       "fill_noise8_2d",         b_fill_noise8_2d },
+    { "noise",       "inoise8_3d",             b_inoise8_3d },
+    { "noise",       "fill_noise8_3d",         b_fill_noise8_3d },
+    { "noise",       "fill_noise8_3d_octaves", b_fill_noise8_3d_octaves },
+    { "noise",       "inoise16_2d",            b_inoise16_2d },
+    { "noise",       "fill_raw_noise8",        b_fill_raw_noise8 },
+    { "lib8tion",    "sin8",                   b_sin8 },
+    { "lib8tion",    "sin16",                  b_sin16 },
+    { "lib8tion",    "sqrt16",                 b_sqrt16 },
+    { "lib8tion",    "random8",                b_random8 },
+    { "framebuffer", "fb_set_pixel_rgb",       b_fb_set_pixel_rgb },
+    { "framebuffer", "fb_fade",                b_fb_fade },
+    { "framebuffer", "fb_blur2d",              b_fb_blur2d },
+    { "framebuffer", "fb_shift",               b_fb_shift },
+};
+
+static void init(void)
+{
+    num = width * height;
+    src = malloc(num * sizeof(rgb_t));
+    dst = malloc(num * sizeof(rgb_t));
+    overlay = malloc(num * sizeof(rgb_t));
+    hsv = malloc(num * sizeof(hsv_t));
+    field = malloc(num);
+    if (!src || !dst || !overlay || !hsv || !field || fb_init(&fb, width, height, render) != ESP_OK)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+
+    random16_set_seed(1);
+    for (size_t i = 0; i < num; i++)
+    {
+        src[i] = rgb_from_values(random8(), random8(), random8());
+        overlay[i] = rgb_from_values(random8(), random8(), random8());
+        hsv[i] = hsv_from_values(random8(), random8(), random8());
+        field[i] = random8();
+    }
+    for (size_t i = 0; i < 16; i++)
+        palette[i] = hsv2rgb_rainbow(hsv_from_values(i * 16, 255, 255));
+    hue_table_init(&hue_table, hsv2rgb_rainbow, 255, 255);
+    rgb_palette_init_rgb(&rgb_palette, palette, 16, 255, true);
+    rgb_lut_init(&lut, 2.2f, 2.2f, 2.2f, rgb_from_values(255, 176, 240), 200);
+    fb_reload();
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-w width] [-h height] [-t min_ms] [-f filter] [-c]\n"
+            "  -w, -h  frame size in pixels, default 32x32\n"
+            "  -t      minimal run time of each benchmark in ms, default 200\n"
+            "  -f      run only benchmarks whose component or name contains filter\n"
+            "  -c      print CSV instead of JSON lines\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+    int64_t min_us = 200000;
+    const char *filter = NULL;
+    bool csv = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "w:h:t:f:c")) != -1)
+    {
+        switch (opt)
+        {
+            case 'w': width = strtoul(optarg, NULL, 0); break;
+            case 'h': height = strtoul(optarg, NULL, 0); break;
+            case 't': min_us = strtoll(optarg, NULL, 0) * 1000; break;
+            case 'f': filter = optarg; break;
+            case 'c': csv = true; break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (!width || !height || min_us <= 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    init();
+
+    if (csv)
+        printf("component,name,width,height,frames,ns_per_pixel,pixels_per_sec\n");
+
+    for (size_t b = 0; b < sizeof(benches) / sizeof(benches[0]); b++)
+    {
+        const bench_t *bench = &benches[b];
+        if (filter && !strstr(bench->name, filter) && !strstr(bench->component, filter))
+            continue;
+
+        // warm up caches and branch predictors
+        bench->run();
+
+        uint64_t frames = 0;
+        int64_t start = esp_timer_get_time(), elapsed;
+        do
+        {
+            for (int i = 0; i < 16; i++, frame++)
+                bench->run();
+            frames += 16;
+            elapsed = esp_timer_get_time() - start;
+        } while (elapsed < min_us);
+        sink += dst[0].r + field[0] + fb.data[0].g;
+
+        double pixels = (double)frames * num;
+        double ns_per_pixel = elapsed * 1000.0 / pixels;
+        double pps = pixels * 1e6 / elapsed;
+
+        if (csv)
+            printf("%s,%s,%zu,%zu,%llu,%.3f,%.0f\n", bench->component, bench->name,
+                   width, height, (unsigned long long)frames, ns_per_pixel, pps);
+        else
+            printf("{\"component\": \"%s\", \"name\": \"%s\", \"width\": %zu, \"height\": %zu, "
+                   "\"frames\": %llu, \"ns_per_pixel\": %.3f, \"pixels_per_sec\": %.0f}\n",
+                   bench->component, bench->name, width, height,
+                   (unsigned long long)frames, ns_per_pixel, pps);
+        fflush(stdout);
+    }
+
+    fb_free(&fb);
+    free(src);
+    free(dst);
+    free(overlay);
+    free(hsv);
+    free(field);
+
+    return 0;
+}
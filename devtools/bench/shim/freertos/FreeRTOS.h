@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  pdTRUE
+#define portMAX_DELAY      0xffffffffu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms)  ((TickType_t)(ms))
@@ -0,0 +1,31 @@
+#pragma once
+
+/* Benchmarks are single-threaded, mutexes always succeed */
+
+#include "FreeRTOS.h"
+
+typedef void *SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    static int dummy;
+    return &dummy;
+}
+
+static inline void vSemaphoreDelete(SemaphoreHandle_t s)
+{
+    (void)s;
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t timeout)
+{
+    (void)s;
+    (void)timeout;
+    return pdTRUE;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t s)
+{
+    (void)s;
+    return pdTRUE;
+}
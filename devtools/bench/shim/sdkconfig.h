@@ -0,0 +1,2 @@
+/* Host build of pure-compute components: no ESP-IDF configuration */
+#pragma once
@@ -21,6 +21,7 @@
 typedef struct
 {
     rgb_t palette[PALETTE_SIZE];
+    rgb_palette_t colors;
 } params_t;
 
 esp_err_t led_effect_fire_init(framebuffer_t *fb, led_effect_fire_palette_t p)
@@ -61,6 +62,9 @@ esp_err_t led_effect_fire_set_params(framebuffer_t *fb, led_effect_fire_palette_
             rgb_fill_gradient4_rgb(params->palette, PALETTE_SIZE, C_BLACK, C_RED, C_YELLOW, C_WHITE);
     }
 
+    // expand palette once, lookups in run() are plain table reads
+    rgb_palette_init_rgb(&params->colors, params->palette, PALETTE_SIZE, 255, true);
+
     return ESP_OK;
 }
 
@@ -87,7 +91,7 @@ esp_err_t led_effect_fire_run(framebuffer_t *fb)
         for (size_t y = 0; y < fb->height; y++)
         {
             uint8_t idx = qsub8(inoise8_3d(x * 60, y * 60 + a, a / 3), abs8(y - (fb->height - 1)) * 255 / (fb->height - 1));
-            rgb_t c = color_from_palette_rgb(params->palette, PALETTE_SIZE, idx, 255, true);
+            rgb_t c = rgb_palette_get(&params->colors, idx);
             fb_set_pixel_rgb(fb, x, fb->height - y - 1, c);
         }
 
@@ -21,13 +21,14 @@ typedef struct
     uint16_t z_pos;
     uint16_t x_offs;
     uint8_t hue;
+    uint8_t field[];
 } params_t;
 
 esp_err_t led_effect_noise_init(framebuffer_t *fb, uint8_t scale, uint8_t speed)
 {
     CHECK_ARG(fb);
 
-    fb->internal = calloc(1, sizeof(params_t));
+    fb->internal = calloc(1, sizeof(params_t) + fb->width * fb->height);
     if (!fb->internal)
         return ESP_ERR_NO_MEM;
 
@@ -67,12 +68,13 @@ esp_err_t led_effect_noise_run(framebuffer_t *fb)
     params->z_pos += params->speed;
     params->hue++;
 
-    for (int x = 0; x < fb->width; x++)
-        for (int y = 0; y < fb->height; y++)
-        {
-            uint8_t noise = inoise8_3d(x * params->scale, y * params->scale, params->z_pos);
-            fb_set_pixel_hsv(fb, x, y, hsv_from_values(params->hue + noise, 255, 255));
-        }
+    fill_noise8_3d(params->field, fb->width, fb->height, fb->width, 1,
+                   0, 0, params->z_pos, params->scale, params->scale);
+
+    uint8_t *noise = params->field;
+    for (int y = 0; y < fb->height; y++)
+        for (int x = 0; x < fb->width; x++, noise++)
+            fb_set_pixel_hsv(fb, x, y, hsv_from_values(params->hue + *noise, 255, 255));
 
     return fb_end(fb);
 }
@@ -28,6 +28,7 @@ typedef struct
     uint8_t cooling;
     uint8_t sparking;
     rgb_t palette[PALETTE_SIZE];
+    rgb_palette_t colors;
     uint8_t *map;
 } params_t;
 
@@ -112,6 +113,9 @@ esp_err_t led_effect_waterfall_set_params(framebuffer_t *fb, led_effect_waterfal
             return ESP_ERR_NOT_SUPPORTED;
     }
 
+    // expand palette once, lookups in run() are plain table reads
+    rgb_palette_init_rgb(&params->colors, params->palette, PALETTE_SIZE, 255, true);
+
     return ESP_OK;
 }
 
@@ -151,7 +155,7 @@ esp_err_t led_effect_waterfall_run(framebuffer_t *fb)
             uint8_t color_idx = scale8(params->map[MAP_XY(x, y)], 240);
             bool is_fire = (params->mode == WATERFALL_FIRE || params->mode == WATERFALL_COLD_FIRE);
             fb_set_pixel_rgb(fb, x, is_fire ? y : fb->height - 1 - y,
-                    color_from_palette_rgb(params->palette, PALETTE_SIZE, color_idx, 255, true));
+                    rgb_palette_get(&params->colors, color_idx));
         }
     }
 
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <inttypes.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <esp_log.h>
@@ -195,11 +196,19 @@ void test(void *pvParameters)
     fb_animation_t animation;
     fb_animation_init(&animation, &fb);
 
+    fb_animation_stats_t stats;
     while (1)
     {
         switch_effect(&animation);
         ESP_LOGI(TAG, "Switching to effect: %d", current_effect);
+        fb_animation_reset_stats(&animation);
         vTaskDelay(pdMS_TO_TICKS(SWITCH_PERIOD_MS));
+
+        fb_animation_get_stats(&animation, &stats);
+        ESP_LOGI(TAG, "Frames drawn: %" PRIu32 ", rendered: %" PRIu32 ", skipped: %" PRIu32 ", dropped: %" PRIu32,
+                stats.frames, stats.rendered, stats.skipped, stats.dropped);
+        ESP_LOGI(TAG, "Max draw time: %" PRIu32 " us, max render time: %" PRIu32 " us",
+                stats.draw_max_us, stats.render_max_us);
     }
 }
 
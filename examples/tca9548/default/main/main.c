@@ -25,10 +25,11 @@ void i2c_switch_test(void *pvParameters)
     // Initialize descriptor of the I2C switch
     ESP_ERROR_CHECK(tca9548_init_desc(&i2c_switch, CONFIG_EXAMPLE_SWITCH_ADDR, 0, CONFIG_EXAMPLE_I2C_MASTER_SDA, CONFIG_EXAMPLE_I2C_MASTER_SCL));
 
-    // Initialize sensors
+    // Attach sensors to the switch channels and initialize them.
+    // Channels will be selected automatically
     for (size_t i = 0; i < SENSOR_COUNT; i++)
     {
-        ESP_ERROR_CHECK(tca9548_set_channels(&i2c_switch, BIT(i)));
+        ESP_ERROR_CHECK(tca9548_attach(&i2c_switch, &sensors[i].i2c_dev, i));
         ESP_ERROR_CHECK(bmp180_init(&sensors[i]));
     }
 
@@ -40,7 +41,6 @@ void i2c_switch_test(void *pvParameters)
 
         for (size_t i = 0; i < SENSOR_COUNT; i++)
         {
-            ESP_ERROR_CHECK(tca9548_set_channels(&i2c_switch, BIT(i)));
             esp_err_t res = bmp180_measure(&sensors[i], &temp, &pressure, BMP180_MODE_STANDARD);
             if (res != ESP_OK)
                 printf("Could not measure on sensor %d: %d\n", i, res);